@@ -0,0 +1,154 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../common/bench_stats.h"
+#include "../common/perm.h"
+#include "../common/hugepage_arena.h"
+
+#define DEFAULT_MB 1024             // Arena capacity
+#define ROUNDS 8                    // Allocate/touch/free rounds per measured run
+#define MIN_OBJECT (64 * 1024)      // Object sizes are log-uniform in [64 KB, 4 MB)
+#define OBJECT_SIZE_LOG2_SPAN 6
+#define MAX_OBJECTS 65536
+#define SIZE_SEED 0xA12E7AULL
+#define TOUCH_STRIDE 4096
+#define CACHE_LINE_SIZE 64
+
+// Large-object churn: each round allocates objects until half the capacity
+// is in use, writes one byte per 4 KB of each (as a consumer filling them
+// would), then releases everything. malloc frees object by object; the arena
+// resets its bump pointer and keeps the faulted-in pages.
+
+typedef struct {
+    const char *name;
+    arena_t *arena;             // NULL: malloc/free
+    size_t *sizes;
+    size_t nobjects;
+    size_t bytes_per_round;
+} churn_ctx_t;
+
+static void *churn_ptrs[MAX_OBJECTS];
+
+static double churn_run(void *arg) {
+    churn_ctx_t *ctx = (churn_ctx_t *)arg;
+    volatile char *sink;
+
+    double start = bench_now_ns();
+    for (int r = 0; r < ROUNDS; r++) {
+        for (size_t i = 0; i < ctx->nobjects; i++) {
+            char *p = ctx->arena ? arena_alloc(ctx->arena, ctx->sizes[i], CACHE_LINE_SIZE)
+                                 : malloc(ctx->sizes[i]);
+            if (!p) {
+                printf("%s: allocation of %zu bytes failed\n", ctx->name, ctx->sizes[i]);
+                exit(1);
+            }
+            for (size_t off = 0; off < ctx->sizes[i]; off += TOUCH_STRIDE) {
+                sink = p + off;
+                *sink = (char)off;
+            }
+            churn_ptrs[i] = p;
+        }
+        if (ctx->arena) {
+            arena_reset(ctx->arena);
+        } else {
+            for (size_t i = 0; i < ctx->nobjects; i++) free(churn_ptrs[i]);
+        }
+    }
+    return bench_elapsed_ms(start);
+}
+
+// Measure one allocator and print its row; returns the median run time
+static double run_variant(churn_ctx_t *ctx, double malloc_ms) {
+    bench_result_t res;
+    bench_repeat(churn_run, ctx, &res);
+
+    double allocs = (double)ctx->nobjects * ROUNDS;
+    double bytes = (double)ctx->bytes_per_round * ROUNDS;
+    printf("%-12s %12.2f %14.0f %10.2f", ctx->name, res.median_ms,
+           allocs / (res.median_ms / 1e3), bytes / (res.median_ms * 1e6));
+    if (malloc_ms > 0) printf(" %9.2fx", malloc_ms / res.median_ms);
+    printf("\n");
+
+    const char *obtained = "malloc";
+    if (ctx->arena) {
+        arena_stats_t st;
+        arena_stats(ctx->arena, &st);
+        obtained = st.obtained;
+    }
+    bench_report_stats("churn", &res, allocs, bytes, "allocator=%s,backing=%s,objects=%zu,rounds=%d",
+                       ctx->name, obtained, ctx->nobjects, ROUNDS);
+    return res.median_ms;
+}
+
+int main(int argc, char *argv[]) {
+    argc = bench_init(argc, argv, "arena_bench");
+    argc = bench_stats_init(argc, argv);
+    size_t mb = argc >= 2 ? strtoull(argv[1], NULL, 10) : DEFAULT_MB;
+    if (mb == 0) {
+        printf("Usage: %s [arena_mb] [--format text|json|csv] [--warmup N] [--reps N]\n", argv[0]);
+        return 1;
+    }
+    size_t capacity = mb * 1024ULL * 1024ULL;
+
+    // One fixed object-size sequence shared by every allocator
+    size_t *sizes = malloc(MAX_OBJECTS * sizeof(size_t));
+    if (!sizes) { perror("malloc sizes"); return 1; }
+    perm_rng_t rng;
+    perm_rng_init(&rng, SIZE_SEED, 0);
+    size_t nobjects = 0, round_bytes = 0;
+    while (nobjects < MAX_OBJECTS) {
+        size_t sz = MIN_OBJECT << perm_below(&rng, OBJECT_SIZE_LOG2_SPAN);
+        sz += perm_below(&rng, sz);
+        // Leave room for alignment padding: stay under half the capacity
+        if (round_bytes + sz + CACHE_LINE_SIZE > capacity / 2) break;
+        sizes[nobjects++] = sz;
+        round_bytes += sz + CACHE_LINE_SIZE;
+    }
+
+    printf("=== Large-Object Churn: malloc vs hugepage arena ===\n");
+    printf("%zu objects (%.2f MB) per round, %d rounds per run, arena %.0f MB\n\n",
+           nobjects, round_bytes / 1048576.0, ROUNDS, capacity / 1048576.0);
+
+    static const struct { const char *name; arena_pages_t pages; } arenas[] = {
+        { "arena-4k", ARENA_PAGES_4K },
+        { "arena-thp", ARENA_PAGES_THP },
+        { "arena-2m", ARENA_PAGES_2M },     // Falls back to THP without a hugetlb pool
+    };
+    arena_t *made[3];
+    for (int i = 0; i < 3; i++) {
+        arena_opts_t opts = ARENA_OPTS_DEFAULT;
+        opts.pages = arenas[i].pages;
+        made[i] = arena_create(capacity, &opts);
+        if (!made[i]) {
+            printf("%s: arena_create failed (%s)\n", arenas[i].name, strerror(errno));
+            continue;
+        }
+        arena_stats_t st;
+        arena_stats(made[i], &st);
+        printf("%s: ", arenas[i].name);
+        arena_print_stats(&st);
+    }
+
+    printf("\n%-12s %12s %14s %10s %10s\n", "Allocator", "Median (ms)", "Allocs/s", "GB/s",
+           "vs malloc");
+    churn_ctx_t ctx = { "malloc", NULL, sizes, nobjects, round_bytes };
+    double malloc_ms = run_variant(&ctx, 0);
+    for (int i = 0; i < 3; i++) {
+        if (!made[i]) continue;
+        churn_ctx_t actx = { arenas[i].name, made[i], sizes, nobjects, round_bytes };
+        run_variant(&actx, malloc_ms);
+    }
+
+    printf("\n");
+    for (int i = 0; i < 3; i++) {
+        if (!made[i]) continue;
+        arena_stats_t st;
+        arena_stats(made[i], &st);
+        printf("%s: ", arenas[i].name);
+        arena_print_stats(&st);
+        arena_destroy(made[i]);
+    }
+    free(sizes);
+    return 0;
+}
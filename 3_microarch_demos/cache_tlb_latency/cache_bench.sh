@@ -1,4 +1,32 @@
-gcc -O2 cache_random_demo.c -o cache_random_demo
+gcc -O2 -pthread cache_random_demo.c -o cache_random_demo -lm
 
 
 ./cache_random_demo
+
+# Pointer-chase latency ladder, 4 KiB .. 4 GiB (pass a smaller max in MB on small boxes)
+./cache_random_demo chase 4096
+
+# Memory-level parallelism: 1..32 interleaved chase chains over a 1 GiB set
+./cache_random_demo mlp 1024
+
+# Software prefetch distance/locality-hint tuner over 64M shuffled elements
+./cache_random_demo prefetch 64
+
+# Sequential/random bandwidth scaling over 1..nproc pinned threads
+./cache_random_demo threads $(nproc) 128
+
+# NUMA node x node latency/bandwidth matrix (single-node report on one socket)
+gcc -O2 -pthread numa_matrix.c -o numa_matrix -lm
+./numa_matrix 256
+
+# Vectorized read/write/copy/triad kernels (+ non-temporal stores) per ISA level
+gcc -O2 stream_bandwidth.c -o stream_bandwidth -lm
+./stream_bandwidth 256
+
+# Large-object churn: malloc vs hugepage arena (common/hugepage_arena.h)
+gcc -O2 -pthread arena_bench.c -o arena_bench -lm
+./arena_bench 1024
+
+# Shared-counter contention scaling: fetch_add vs CAS vs sharded vs per-CPU
+gcc -O2 -pthread contention_test.c -o contention_test -lm
+./contention_test $(nproc)
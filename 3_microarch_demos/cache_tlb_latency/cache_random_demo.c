@@ -3,27 +3,227 @@
 #include <stdlib.h>
 #include <time.h>
 #include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "../false_sharing_perf_demo/bind_threads.h"
+#include "../common/perm.h"
+#include "../common/bench_stats.h"
 
 #define N (1024 * 1024 * 256)  // 256M elements (~1GB)
 #define REPEAT 1               // Adjustable, repeat access count
+#define PERM_SEED 0xC0FFEE     // Fixed seed so every run walks the same permutation
+
+#define CACHE_LINE_SIZE 64
+#define CHASE_MIN_BYTES (4 * 1024)          // Start of the latency ladder: 4 KiB
+#define CHASE_DEFAULT_MAX_MB 4096           // End of the latency ladder: 4 GiB
+#define CHASE_LOADS (1 << 24)               // Dependent loads timed per working-set size
+#define MLP_MAX_CHAINS 32                   // Independent chains interleaved in the MLP sweep
+#define MLP_DEFAULT_MB 1024                 // DRAM-sized working set for the MLP sweep
+#define PREFETCH_DEFAULT_M 64               // Elements (in millions) for the prefetch tuner
+#define THREADS_DEFAULT_M 128               // Elements (in millions) for the thread scaling sweep
+
+// One node per cache line so every hop of the chase touches a new line
+typedef struct {
+    size_t next;
+    char pad[CACHE_LINE_SIZE - sizeof(size_t)];
+} chase_node_t;
 
 static int *arr;           // Large array
 static size_t *index_seq;  // Access sequence array (sequential or random)
 
-// Generate random access sequence
-void shuffle(size_t *idx, size_t n) {
-    for (size_t i = n - 1; i > 0; i--) {
-        size_t j = rand() % (i + 1);
-        size_t tmp = idx[i];
-        idx[i] = idx[j];
-        idx[j] = tmp;
+// Generate random access sequence (parallel, unbiased); returns setup time in ms
+double shuffle(size_t *idx, size_t n) {
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    perm_shuffle(idx, n, PERM_SEED, 0);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return (end.tv_sec - start.tv_sec) * 1e3 +
+           (end.tv_nsec - start.tv_nsec) / 1e6;
+}
+
+// Link the first n nodes into one random cycle of length n by following a
+// random visiting order, so the walk touches every node before returning to
+// the start. order (n entries) is left holding the visiting order.
+// Returns setup time in ms.
+double build_chase_cycle(chase_node_t *nodes, size_t n, size_t *order) {
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    perm_random_order(order, n, PERM_SEED, 0);
+    for (size_t i = 0; i + 1 < n; i++) {
+        nodes[order[i]].next = order[i + 1];
     }
+    nodes[order[n - 1]].next = order[0];
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return (end.tv_sec - start.tv_sec) * 1e3 +
+           (end.tv_nsec - start.tv_nsec) / 1e6;
+}
+
+// One chase (or k interleaved chases, see mlp_run) timed by bench_repeat
+typedef struct {
+    chase_node_t *nodes;
+    const size_t *starts;       // One start node per chain
+    int chains;
+    size_t loads;               // Total over all chains
+} chase_ctx_t;
+
+// Each load depends on the previous one, so the CPU cannot overlap misses:
+// the result is true load-to-use latency rather than throughput. The
+// bench_repeat warm-up runs walk the same cycle first, warming caches/TLB.
+static double chase_run(void *arg) {
+    chase_ctx_t *ctx = (chase_ctx_t *)arg;
+    chase_node_t *nodes = ctx->nodes;
+    size_t p = ctx->starts[0];
+
+    pc_region_begin();
+    double start = bench_now_ns();
+    for (size_t i = 0; i < ctx->loads; i++) {
+        p = nodes[p].next;
+    }
+    double elapsed = bench_elapsed_ms(start);
+    pc_region_end();
+
+    // Prevent compiler from optimizing away the chase
+    if (p == (size_t)-1) printf("p=%zu\n", p);
+    return elapsed;
+}
+
+// Latency ladder: walk a single-cycle permutation for working sets from
+// 4 KiB up to max_mb and print ns per dependent load at each step
+int run_chase_ladder(size_t max_mb) {
+    size_t max_bytes = max_mb * 1024ULL * 1024ULL;
+    if (max_bytes < CHASE_MIN_BYTES) max_bytes = CHASE_MIN_BYTES;
+
+    printf("Allocating %.2f MB for pointer chase...\n", max_bytes / 1024.0 / 1024.0);
+    chase_node_t *nodes = aligned_alloc(CACHE_LINE_SIZE, max_bytes);
+    if (!nodes) { perror("aligned_alloc nodes"); return 1; }
+    size_t *order = malloc(max_bytes / sizeof(chase_node_t) * sizeof(size_t));
+    if (!order) { perror("malloc order"); return 1; }
+
+    printf("\n=== Pointer-Chase Latency Ladder ===\n");
+    printf("%14s %12s %12s %12s %14s\n", "Working set", "ns/load", "MAD ns", "vs prev", "Setup (ms)");
+
+    double prev = 0;
+    const size_t start = 0;
+    for (size_t bytes = CHASE_MIN_BYTES; bytes <= max_bytes; bytes *= 2) {
+        size_t n = bytes / sizeof(chase_node_t);
+        double setup_ms = build_chase_cycle(nodes, n, order);
+        chase_ctx_t ctx = { nodes, &start, 1, CHASE_LOADS };
+        bench_result_t res;
+        bench_repeat(chase_run, &ctx, &res);
+        double ns = res.median_ms * 1e6 / CHASE_LOADS;
+
+        if (bytes >= 1024ULL * 1024ULL * 1024ULL) {
+            printf("%10.0f GiB", bytes / 1024.0 / 1024.0 / 1024.0);
+        } else if (bytes >= 1024ULL * 1024ULL) {
+            printf("%10.0f MiB", bytes / 1024.0 / 1024.0);
+        } else {
+            printf("%10.0f KiB", bytes / 1024.0);
+        }
+        printf(" %12.2f %12.2f", ns, res.mad_ms * 1e6 / CHASE_LOADS);
+        if (prev > 0) {
+            printf(" %11.2fx", ns / prev);
+        } else {
+            printf(" %12s", "");
+        }
+        printf(" %14.2f\n", setup_ms);
+        prev = ns;
+
+        bench_report_stats("pointer_chase", &res, CHASE_LOADS, 0,
+                           "working_set_bytes=%zu", bytes);
+    }
+
+    free(order);
+    free(nodes);
+    return 0;
+}
+
+// Interleave k independent chases in one thread. Within one round the k loads
+// have no dependency on each other, so the core can keep k misses in flight.
+// ctx->loads must be a multiple of ctx->chains.
+static double mlp_run(void *arg) {
+    chase_ctx_t *ctx = (chase_ctx_t *)arg;
+    chase_node_t *nodes = ctx->nodes;
+    size_t p[MLP_MAX_CHAINS];
+    int k = ctx->chains;
+    size_t rounds = ctx->loads / k;
+
+    for (int c = 0; c < k; c++) {
+        p[c] = ctx->starts[c];
+    }
+
+    pc_region_begin();
+    double start = bench_now_ns();
+    for (size_t i = 0; i < rounds; i++) {
+        for (int c = 0; c < k; c++) {
+            p[c] = nodes[p[c]].next;
+        }
+    }
+    double elapsed = bench_elapsed_ms(start);
+    pc_region_end();
+
+    size_t check = 0;
+    for (int c = 0; c < k; c++) check ^= p[c];
+    if (check == (size_t)-1) printf("check=%zu\n", check);
+    return elapsed;
+}
+
+// MLP sweep: 1..32 chains over one DRAM-sized cycle. The single-chain result is
+// the miss latency, so by Little's law latency / (ns per load) at k chains is
+// the number of misses the core actually keeps outstanding.
+int run_mlp_sweep(size_t ws_mb) {
+    size_t bytes = ws_mb * 1024ULL * 1024ULL;
+    size_t n = bytes / sizeof(chase_node_t);
+    if (n < MLP_MAX_CHAINS * 2) {
+        printf("Working set too small for %d chains\n", MLP_MAX_CHAINS);
+        return 1;
+    }
+
+    printf("Allocating %.2f MB for MLP sweep...\n", bytes / 1024.0 / 1024.0);
+    chase_node_t *nodes = aligned_alloc(CACHE_LINE_SIZE, n * sizeof(chase_node_t));
+    if (!nodes) { perror("aligned_alloc nodes"); return 1; }
+    size_t *order = malloc(n * sizeof(size_t));
+    if (!order) { perror("malloc order"); return 1; }
+    printf("Setup (cycle build): %.2f ms\n", build_chase_cycle(nodes, n, order));
+
+    // Start points spaced n/32 hops apart along the cycle; with at most n loads
+    // in total the chains never run into each other's segment
+    size_t starts[MLP_MAX_CHAINS];
+    size_t spacing = n / MLP_MAX_CHAINS;
+    for (int c = 0; c < MLP_MAX_CHAINS; c++) {
+        starts[c] = order[c * spacing];
+    }
+    free(order);
+
+    size_t loads = n < CHASE_LOADS ? n : CHASE_LOADS;
+
+    printf("\n=== Memory-Level Parallelism Sweep (%.0f MiB) ===\n", bytes / 1024.0 / 1024.0);
+    printf("%8s %12s %12s %12s %14s\n", "Chains", "ns/load", "MAD ns", "GB/s", "Outstanding");
+
+    double latency = 0;
+    for (int k = 1; k <= MLP_MAX_CHAINS; k++) {
+        size_t chain_starts[MLP_MAX_CHAINS];
+        for (int c = 0; c < k; c++) {
+            chain_starts[c] = starts[c * MLP_MAX_CHAINS / k];
+        }
+        chase_ctx_t ctx = { nodes, chain_starts, k, loads / k * k };
+        bench_result_t res;
+        bench_repeat(mlp_run, &ctx, &res);
+        double ns = res.median_ms * 1e6 / ctx.loads;
+        if (k == 1) latency = ns;
+        printf("%8d %12.2f %12.2f %12.2f %14.2f\n", k, ns, res.mad_ms * 1e6 / ctx.loads,
+               CACHE_LINE_SIZE / ns, latency / ns);
+        bench_report_stats("mlp", &res, ctx.loads, (double)ctx.loads * CACHE_LINE_SIZE,
+                           "chains=%d,working_set_bytes=%zu", k, bytes);
+    }
+
+    free(nodes);
+    return 0;
 }
 
 double timed_access(size_t *seq, size_t n) {
     volatile long long sum = 0;
-    struct timespec start, end;
-    clock_gettime(CLOCK_MONOTONIC, &start);
+    pc_region_begin();
+    double start = bench_now_ns();
 
     for (int r = 0; r < REPEAT; r++) {
         for (size_t i = 0; i < n; i++) {
@@ -31,42 +231,318 @@ double timed_access(size_t *seq, size_t n) {
         }
     }
 
-    clock_gettime(CLOCK_MONOTONIC, &end);
-    double elapsed = (end.tv_sec - start.tv_sec) * 1e3 +
-                     (end.tv_nsec - start.tv_nsec) / 1e6;
+    double elapsed = bench_elapsed_ms(start);
+    pc_region_end();
     // Prevent compiler from optimizing away access
     if (sum == 42) printf("sum=%lld\n", sum);
     return elapsed;
 }
 
-int main() {
-    srand(0xC0FFEE);
+typedef struct {
+    size_t *seq;
+    size_t n;
+} access_ctx_t;
 
-    size_t elements = N;
+static double timed_access_run(void *arg) {
+    access_ctx_t *ctx = (access_ctx_t *)arg;
+    return timed_access(ctx->seq, ctx->n);
+}
+
+// Same random pass as timed_access(), but prefetches the element that will be
+// needed dist iterations later. The locality hint must be a compile-time
+// constant, so one function is stamped out per hint.
+#define DEFINE_PREFETCH_ACCESS(HINT)                                        \
+static double timed_prefetch_access_##HINT(size_t *seq, size_t n, size_t dist) { \
+    volatile long long sum = 0;                                             \
+    size_t head = n > dist ? n - dist : 0;                                  \
+    pc_region_begin();                                                      \
+    double start = bench_now_ns();                                          \
+    for (size_t i = 0; i < head; i++) {                                     \
+        __builtin_prefetch(&arr[seq[i + dist]], 0, HINT);                   \
+        sum += arr[seq[i]];                                                 \
+    }                                                                       \
+    for (size_t i = head; i < n; i++) {                                     \
+        sum += arr[seq[i]];                                                 \
+    }                                                                       \
+    double elapsed = bench_elapsed_ms(start);                               \
+    pc_region_end();                                                        \
+    if (sum == 42) printf("sum=%lld\n", sum);                               \
+    return elapsed;                                                         \
+}
+
+DEFINE_PREFETCH_ACCESS(0)
+DEFINE_PREFETCH_ACCESS(1)
+DEFINE_PREFETCH_ACCESS(2)
+DEFINE_PREFETCH_ACCESS(3)
+
+static double (*const prefetch_access[4])(size_t *, size_t, size_t) = {
+    timed_prefetch_access_0, timed_prefetch_access_1,
+    timed_prefetch_access_2, timed_prefetch_access_3,
+};
+
+static const char *const prefetch_hint_names[4] = {
+    "NTA(0)", "T2(1)", "T1(2)", "T0(3)",
+};
+
+typedef struct {
+    size_t *seq;
+    size_t n;
+    size_t dist;
+    int hint;
+} prefetch_ctx_t;
+
+static double prefetch_run(void *arg) {
+    prefetch_ctx_t *ctx = (prefetch_ctx_t *)arg;
+    return prefetch_access[ctx->hint](ctx->seq, ctx->n, ctx->dist);
+}
+
+// Allocate arr/index_seq and fill them with the identity sequence
+int alloc_arrays(size_t elements) {
     size_t bytes = elements * sizeof(int);
 
     printf("Allocating %.2f MB...\n", bytes / 1024.0 / 1024.0);
     arr = malloc(bytes);
-    if (!arr) { perror("malloc arr"); return 1; }
+    if (!arr) { perror("malloc arr"); return -1; }
     index_seq = malloc(elements * sizeof(size_t));
-    if (!index_seq) { perror("malloc seq"); return 1; }
+    if (!index_seq) { perror("malloc seq"); return -1; }
 
     // Initialize array
     for (size_t i = 0; i < elements; i++) {
         arr[i] = (int)i;
         index_seq[i] = i;
     }
+    return 0;
+}
+
+typedef struct {
+    int core;
+    size_t lo, hi;               // Slice of index_seq owned by this thread
+    pthread_barrier_t *barrier;
+    bench_span_t span;
+} bw_worker_t;
+
+void *bw_worker(void *arg) {
+    bw_worker_t *w = (bw_worker_t *)arg;
+    bind_thread_to_core(w->core);
+
+    volatile long long sum = 0;
+    pthread_barrier_wait(w->barrier);
+    bench_span_begin(&w->span);
+    for (size_t i = w->lo; i < w->hi; i++) {
+        sum += arr[index_seq[i]];
+    }
+    bench_span_end(&w->span);
+
+    if (sum == 42) printf("sum=%lld\n", sum);
+    return NULL;
+}
+
+typedef struct {
+    size_t elements;
+    int nthreads;
+    bw_worker_t *workers;
+    int runs;                    // Calls so far, warm-up included
+    double per_thread_gbps[BENCH_MAX_REPS];    // Mean over threads, ring indexed by runs
+} threaded_ctx_t;
+
+// Run one pass over index_seq split into nthreads contiguous slices, one pinned
+// thread per slice. Returns the span from the first worker start to the last
+// worker end.
+static double threaded_access_run(void *arg) {
+    threaded_ctx_t *ctx = (threaded_ctx_t *)arg;
+    int nthreads = ctx->nthreads;
+    bw_worker_t *workers = ctx->workers;
+    pthread_t tids[nthreads];
+    pthread_barrier_t barrier;
+    pthread_barrier_init(&barrier, NULL, nthreads + 1);
+    pc_region_begin();
+    for (int t = 0; t < nthreads; t++) {
+        workers[t].core = topo_cpu_for_thread(t);
+        workers[t].lo = ctx->elements * t / nthreads;
+        workers[t].hi = ctx->elements * (t + 1) / nthreads;
+        workers[t].barrier = &barrier;
+        pthread_create(&tids[t], NULL, bw_worker, &workers[t]);
+    }
+
+    pthread_barrier_wait(&barrier);
+    for (int t = 0; t < nthreads; t++) {
+        pthread_join(tids[t], NULL);
+    }
+    pc_region_end();
+    pthread_barrier_destroy(&barrier);
+
+    const double bytes_per_access = sizeof(int) + sizeof(size_t);
+    double per_thread = 0;
+    for (int t = 0; t < nthreads; t++) {
+        size_t n = workers[t].hi - workers[t].lo;
+        per_thread += n * bytes_per_access / (bench_span_ms(&workers[t].span, 1, 0) * 1e6);
+    }
+    ctx->per_thread_gbps[ctx->runs++ % BENCH_MAX_REPS] = per_thread / nthreads;
+    return bench_span_ms(&workers[0].span, nthreads, sizeof(workers[0]));
+}
+
+// Thread scaling: 1..max_threads pinned threads over the sequential and then
+// the shuffled index_seq. Bytes counted are the ones the loop loads
+// (one int from arr plus one size_t from index_seq per access).
+int run_thread_scaling(int max_threads, size_t elements) {
+    if (alloc_arrays(elements) != 0) return 1;
+
+    bw_worker_t *workers = calloc(max_threads, sizeof(bw_worker_t));
+    if (!workers) { perror("calloc workers"); return 1; }
+
+    const double bytes_per_access = sizeof(int) + sizeof(size_t);
+    const char *patterns[2] = { "Sequential", "Random" };
+
+    for (int pat = 0; pat < 2; pat++) {
+        if (pat == 1) printf("\nSetup (shuffle): %.2f ms\n", shuffle(index_seq, elements));
+
+        printf("\n=== %s Bandwidth Scaling ===\n", patterns[pat]);
+        printf("%8s %12s %14s %16s %12s\n",
+               "Threads", "Median (ms)", "Aggregate GB/s", "Per-thread GB/s", "Scaling");
+
+        double base = 0;
+        for (int t = 1; t <= max_threads; t++) {
+            static threaded_ctx_t ctx;
+            ctx.elements = elements;
+            ctx.nthreads = t;
+            ctx.workers = workers;
+            ctx.runs = 0;
+            bench_result_t res;
+            bench_repeat(threaded_access_run, &ctx, &res);
+            double agg = elements * bytes_per_access / (res.median_ms * 1e6);
+
+            // Median over the measured runs, the last bench_reps in the ring
+            double per_thread[BENCH_MAX_REPS];
+            for (int i = 0; i < bench_reps; i++) {
+                per_thread[i] = ctx.per_thread_gbps[(ctx.runs - bench_reps + i) % BENCH_MAX_REPS];
+            }
+            qsort(per_thread, bench_reps, sizeof(double), bench_cmp_double);
+
+            if (t == 1) base = agg;
+            printf("%8d %12.2f %14.2f %16.2f %11.2fx\n",
+                   t, res.median_ms, agg, bench_median(per_thread, bench_reps), agg / base);
+            bench_report_stats(pat == 0 ? "bandwidth_sequential" : "bandwidth_random",
+                               &res, elements, elements * bytes_per_access,
+                               "threads=%d,elements=%zu", t, elements);
+        }
+    }
+
+    free(workers);
+    free(arr);
+    free(index_seq);
+    return 0;
+}
+
+// Prefetch tuner: sweep distance D and locality hint over the shuffled
+// index_seq and report the best setting against the plain random pass
+int run_prefetch_tuner(size_t elements) {
+    static const size_t distances[] = { 1, 2, 4, 8, 16, 32, 64, 128, 256, 512 };
+    const int num_distances = sizeof(distances) / sizeof(distances[0]);
+
+    if (alloc_arrays(elements) != 0) return 1;
+    printf("Setup (shuffle): %.2f ms\n", shuffle(index_seq, elements));
+
+    printf("\n=== Software Prefetch Distance Tuner ===\n");
+    access_ctx_t plain = { index_seq, elements };
+    bench_result_t res;
+    bench_repeat(timed_access_run, &plain, &res);
+    double t_plain = res.median_ms;
+    printf("Plain random pass: ");
+    bench_print_stats(&res);
+    printf("\nCells: median ms over the measured runs\n");
+    bench_report_stats("prefetch_plain", &res, elements, 0, "elements=%zu", elements);
+
+    printf("%10s", "Distance");
+    for (int h = 0; h < 4; h++) printf(" %14s", prefetch_hint_names[h]);
+    printf("\n");
+
+    double best = t_plain;
+    size_t best_dist = 0;
+    int best_hint = -1;
+    for (int d = 0; d < num_distances; d++) {
+        printf("%10zu", distances[d]);
+        for (int h = 0; h < 4; h++) {
+            prefetch_ctx_t ctx = { index_seq, elements, distances[d], h };
+            bench_repeat(prefetch_run, &ctx, &res);
+            double t = res.median_ms;
+            printf(" %9.2f ms  ", t);
+            fflush(stdout);
+            bench_report_stats("prefetch", &res, elements, 0, "elements=%zu,distance=%zu,hint=%d",
+                               elements, distances[d], h);
+            if (t < best) {
+                best = t;
+                best_dist = distances[d];
+                best_hint = h;
+            }
+        }
+        printf("\n");
+    }
+
+    if (best_hint < 0) {
+        printf("\nNo prefetch setting beat the plain random pass\n");
+    } else {
+        printf("\nBest: distance %zu, hint %s: %.2f ms (%.2fx speedup over plain)\n",
+               best_dist, prefetch_hint_names[best_hint], best, t_plain / best);
+    }
+
+    free(arr);
+    free(index_seq);
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    argc = bench_init(argc, argv, "cache_random_demo");
+    argc = bench_stats_init(argc, argv);
+    argc = topo_init_args(argc, argv);
+
+    if (argc >= 2 && strcmp(argv[1], "chase") == 0) {
+        size_t max_mb = argc >= 3 ? strtoull(argv[2], NULL, 10) : CHASE_DEFAULT_MAX_MB;
+        return run_chase_ladder(max_mb);
+    }
+    if (argc >= 2 && strcmp(argv[1], "mlp") == 0) {
+        size_t ws_mb = argc >= 3 ? strtoull(argv[2], NULL, 10) : MLP_DEFAULT_MB;
+        return run_mlp_sweep(ws_mb);
+    }
+    if (argc >= 2 && strcmp(argv[1], "prefetch") == 0) {
+        size_t millions = argc >= 3 ? strtoull(argv[2], NULL, 10) : PREFETCH_DEFAULT_M;
+        return run_prefetch_tuner(millions * 1000000ULL);
+    }
+    if (argc >= 2 && strcmp(argv[1], "threads") == 0) {
+        int max_threads = argc >= 3 ? atoi(argv[2]) : (int)sysconf(_SC_NPROCESSORS_ONLN);
+        size_t millions = argc >= 4 ? strtoull(argv[3], NULL, 10) : THREADS_DEFAULT_M;
+        if (max_threads < 1) max_threads = 1;
+        return run_thread_scaling(max_threads, millions * 1000000ULL);
+    }
+    if (argc >= 2) {
+        printf("Usage: %s [chase [max_mb] | mlp [ws_mb] | prefetch [m_elements] |\n"
+               "        threads [max_threads] [m_elements]] [--format text|json|csv]\n"
+               "        [--warmup N] [--reps N] [--timer clock|tsc] [--counters]\n"
+               "        [--placement linear|cores|pack|spread]\n", argv[0]);
+        return 1;
+    }
+
+    size_t elements = N;
+    if (alloc_arrays(elements) != 0) return 1;
+
+    double bytes_per_pass = elements * (double)(sizeof(int) + sizeof(size_t));
+    access_ctx_t ctx = { index_seq, elements };
+    bench_result_t seq_res, rand_res;
 
     printf("\n=== Sequential Access ===\n");
-    double t_seq = timed_access(index_seq, elements);
-    printf("Time: %.2f ms\n", t_seq);
+    bench_repeat(timed_access_run, &ctx, &seq_res);
+    bench_print_stats(&seq_res);
+    bench_report_stats("sequential_access", &seq_res, elements, bytes_per_pass,
+                       "elements=%zu", elements);
 
     printf("\n=== Random Access ===\n");
-    shuffle(index_seq, elements);
-    double t_rand = timed_access(index_seq, elements);
-    printf("Time: %.2f ms\n", t_rand);
+    printf("Setup (shuffle): %.2f ms\n", shuffle(index_seq, elements));
+    bench_repeat(timed_access_run, &ctx, &rand_res);
+    bench_print_stats(&rand_res);
+    bench_report_stats("random_access", &rand_res, elements, bytes_per_pass,
+                       "elements=%zu", elements);
 
-    printf("\nSlowdown (Random vs Sequential): %.2fx\n", t_rand / t_seq);
+    printf("\nSlowdown (Random vs Sequential): %.2fx\n",
+           rand_res.median_ms / seq_res.median_ms);
 
     free(arr);
     free(index_seq);
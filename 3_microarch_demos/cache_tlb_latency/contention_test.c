@@ -1,20 +1,208 @@
+#define _GNU_SOURCE
 #include <pthread.h>
+#include <sched.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../false_sharing_perf_demo/bind_threads.h"
+#include "../common/bench_stats.h"
 
-volatile long shared_var = 0;
+#if __has_include(<sys/rseq.h>)
+#include <sys/rseq.h>
+#define HAVE_RSEQ 1
+#endif
 
-void* worker(void* arg) {
-    for (long i = 0; i < 100000000; i++) {
-        shared_var++;  // 多个核同时写同一变量 → 争用
+#define OPS_PER_THREAD 5000000
+#define MAX_THREADS 256
+#define MAX_CPUS 1024
+#define SLOT_SIZE 128               // Two lines: keeps the adjacent-line prefetcher out
+
+// Shared-counter scaling: N pinned threads each add 1 OPS_PER_THREAD times.
+//   fetch_add  one shared counter, lock xadd / ldadd
+//   cas        one shared counter, load + compare-exchange retry loop
+//   sharded    one padded slot per thread, summed lazily by the reader
+//   percpu     one padded slot per CPU, found via rseq cpu_id (sched_getcpu
+//              fallback); atomic add because threads may share or migrate CPUs
+// Efficiency at N threads = throughput(N) / (N * throughput(1)).
+
+typedef struct {
+    long value;
+    char pad[SLOT_SIZE - sizeof(long)];
+} slot_t;
+
+static slot_t shared __attribute__((aligned(SLOT_SIZE)));
+static slot_t thread_slots[MAX_THREADS] __attribute__((aligned(SLOT_SIZE)));
+static slot_t cpu_slots[MAX_CPUS] __attribute__((aligned(SLOT_SIZE)));
+static int use_rseq;
+
+static inline int current_cpu(void) {
+#ifdef HAVE_RSEQ
+    if (use_rseq) {
+        struct rseq *rs = (struct rseq *)((char *)__builtin_thread_pointer() + __rseq_offset);
+        return (int)__atomic_load_n(&rs->cpu_id, __ATOMIC_RELAXED);
+    }
+#endif
+    return sched_getcpu();
+}
+
+static void count_fetch_add(int tid, long ops) {
+    (void)tid;
+    for (long i = 0; i < ops; i++) {
+        __atomic_fetch_add(&shared.value, 1, __ATOMIC_RELAXED);
+    }
+}
+
+static void count_cas(int tid, long ops) {
+    (void)tid;
+    for (long i = 0; i < ops; i++) {
+        long old = __atomic_load_n(&shared.value, __ATOMIC_RELAXED);
+        while (!__atomic_compare_exchange_n(&shared.value, &old, old + 1, 1,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        }
     }
+}
+
+// Only the owner writes its slot, so a relaxed load + store is enough and no
+// locked instruction is needed; readers may see a slightly stale sum
+static void count_sharded(int tid, long ops) {
+    long *v = &thread_slots[tid].value;
+    for (long i = 0; i < ops; i++) {
+        __atomic_store_n(v, __atomic_load_n(v, __ATOMIC_RELAXED) + 1, __ATOMIC_RELAXED);
+    }
+}
+
+static void count_percpu(int tid, long ops) {
+    (void)tid;
+    for (long i = 0; i < ops; i++) {
+        int cpu = current_cpu();
+        __atomic_fetch_add(&cpu_slots[cpu % MAX_CPUS].value, 1, __ATOMIC_RELAXED);
+    }
+}
+
+static long read_shared(void) { return __atomic_load_n(&shared.value, __ATOMIC_RELAXED); }
+
+static long read_sharded(void) {
+    long sum = 0;
+    for (int i = 0; i < MAX_THREADS; i++) sum += __atomic_load_n(&thread_slots[i].value, __ATOMIC_RELAXED);
+    return sum;
+}
+
+static long read_percpu(void) {
+    long sum = 0;
+    for (int i = 0; i < MAX_CPUS; i++) sum += __atomic_load_n(&cpu_slots[i].value, __ATOMIC_RELAXED);
+    return sum;
+}
+
+typedef struct {
+    const char *name;
+    void (*count)(int tid, long ops);
+    long (*read)(void);
+} counter_impl_t;
+
+static const counter_impl_t impls[] = {
+    { "fetch_add", count_fetch_add, read_shared },
+    { "cas",       count_cas,       read_shared },
+    { "sharded",   count_sharded,   read_sharded },
+    { "percpu",    count_percpu,    read_percpu },
+};
+#define NUM_IMPLS (int)(sizeof(impls) / sizeof(impls[0]))
+
+typedef struct {
+    const counter_impl_t *impl;
+    int nthreads;
+    int ok;                     // Last run's total matched
+} run_ctx_t;
+
+typedef struct {
+    int tid;
+    int core;
+    const counter_impl_t *impl;
+    pthread_barrier_t *barrier;
+    bench_span_t span;
+} worker_t;
+
+static void *worker(void *arg) {
+    worker_t *w = (worker_t *)arg;
+    bind_thread_to_core(w->core);
+    pthread_barrier_wait(w->barrier);
+    bench_span_begin(&w->span);
+    w->impl->count(w->tid, OPS_PER_THREAD);
+    bench_span_end(&w->span);
     return NULL;
 }
 
-int main() {
-    pthread_t t1, t2;
-    pthread_create(&t1, NULL, worker, NULL);
-    pthread_create(&t2, NULL, worker, NULL);
-    pthread_join(t1, NULL);
-    pthread_join(t2, NULL);
+static double run_once(void *arg) {
+    run_ctx_t *ctx = (run_ctx_t *)arg;
+    pthread_t tids[MAX_THREADS];
+    worker_t workers[MAX_THREADS];
+    pthread_barrier_t barrier;
+
+    memset(&shared, 0, sizeof(shared));
+    memset(thread_slots, 0, sizeof(thread_slots));
+    memset(cpu_slots, 0, sizeof(cpu_slots));
+    pthread_barrier_init(&barrier, NULL, ctx->nthreads + 1);
+    pc_region_begin();
+    for (int t = 0; t < ctx->nthreads; t++) {
+        workers[t] = (worker_t){ t, topo_cpu_for_thread(t), ctx->impl, &barrier, { 0, 0 } };
+        pthread_create(&tids[t], NULL, worker, &workers[t]);
+    }
+
+    pthread_barrier_wait(&barrier);
+    for (int t = 0; t < ctx->nthreads; t++) pthread_join(tids[t], NULL);
+    pc_region_end();
+    pthread_barrier_destroy(&barrier);
+    double elapsed = bench_span_ms(&workers[0].span, ctx->nthreads, sizeof(workers[0]));
+
+    ctx->ok = ctx->impl->read() == (long)ctx->nthreads * OPS_PER_THREAD;
+    return elapsed;
+}
+
+int main(int argc, char *argv[]) {
+    argc = bench_init(argc, argv, "contention_test");
+    argc = bench_stats_init(argc, argv);
+    argc = topo_init_args(argc, argv);
+    int max_threads = argc >= 2 ? atoi(argv[1]) : topo_get()->ncpus;
+    if (max_threads < 1 || max_threads > MAX_THREADS) {
+        printf("Usage: %s [max_threads<=%d] [--format text|json|csv] [--warmup N] [--reps N]\n        [--placement linear|cores|pack|spread]\n",
+               argv[0], MAX_THREADS);
+        return 1;
+    }
+
+#ifdef HAVE_RSEQ
+    use_rseq = __rseq_size > 0;
+#endif
+    printf("=== Counter Contention Scaling ===\n");
+    printf("%d ops per thread, percpu via %s\n", OPS_PER_THREAD,
+           use_rseq ? "rseq cpu_id" : "sched_getcpu()");
+    topo_print(topo_get());
+    printf("\n");
+
+    printf("%8s", "Threads");
+    for (int i = 0; i < NUM_IMPLS; i++) printf(" %16s %6s", impls[i].name, "eff");
+    printf("\n");
+
+    double base[NUM_IMPLS] = { 0 };
+    // 1, 2, 4, ... and finally max_threads itself
+    for (int n = 1;; n *= 2) {
+        if (n > max_threads) n = max_threads;
+        printf("%8d", n);
+        for (int i = 0; i < NUM_IMPLS; i++) {
+            run_ctx_t ctx = { &impls[i], n, 0 };
+            bench_result_t res;
+            bench_repeat(run_once, &ctx, &res);
+
+            double ops = (double)n * OPS_PER_THREAD;
+            double mops = ops / (res.median_ms * 1e3);
+            if (n == 1) base[i] = mops;
+            double eff = mops / (n * base[i]);
+            printf(" %10.1f Mop/s %5.0f%%%s", mops, eff * 100, ctx.ok ? "" : "!");
+            fflush(stdout);
+            bench_report_stats("contention", &res, ops, 0, "counter=%s,threads=%d,efficiency=%.3f",
+                               impls[i].name, n, eff);
+        }
+        printf("\n");
+        if (n == max_threads) break;
+    }
+    printf("\n(! = final count mismatch; eff = throughput / (threads x single-thread throughput))\n");
     return 0;
 }
@@ -0,0 +1,274 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include "../false_sharing_perf_demo/bind_threads.h"
+#include "../common/perm.h"
+#include "../common/bench_stats.h"
+
+#define MAX_NODES 64
+#define DEFAULT_MB 256              // Buffer per matrix cell, well beyond any LLC
+#define CACHE_LINE_SIZE 64
+#define CHASE_LOADS (1 << 23)       // Dependent loads per latency cell
+#define PERM_SEED 0xC0FFEE
+
+// From <linux/mempolicy.h>; spelled out so the demo needs no libnuma
+#define MPOL_BIND 2
+#define MPOL_MF_STRICT (1 << 0)
+#define MPOL_MF_MOVE (1 << 1)
+
+typedef struct {
+    size_t next;
+    char pad[CACHE_LINE_SIZE - sizeof(size_t)];
+} chase_node_t;
+
+static int num_nodes;
+static int node_ids[MAX_NODES];     // Online node ids (may be sparse)
+static int node_cpu[MAX_NODES];     // First online CPU of each node, -1 if memory-only
+
+// Parse a sysfs list such as "0-3,8,10-11" and return up to max entries
+static int parse_list(const char *path, int *out, int max) {
+    FILE *f = fopen(path, "r");
+    if (!f) return 0;
+
+    char buf[4096];
+    int count = 0;
+    if (fgets(buf, sizeof(buf), f)) {
+        char *tok = strtok(buf, ",\n");
+        while (tok && count < max) {
+            int lo, hi;
+            if (sscanf(tok, "%d-%d", &lo, &hi) == 2) {
+                for (int i = lo; i <= hi && count < max; i++) out[count++] = i;
+            } else if (sscanf(tok, "%d", &lo) == 1) {
+                out[count++] = lo;
+            }
+            tok = strtok(NULL, ",\n");
+        }
+    }
+    fclose(f);
+    return count;
+}
+
+// Discover online nodes. Memory-only nodes (CXL expanders, HBM) have an
+// empty cpulist: they are memory columns but have no CPU row. A kernel
+// without NUMA support (no /sys/devices/system/node) is reported as a single
+// node 0 with CPU 0.
+static void discover_nodes(void) {
+    int ids[MAX_NODES];
+    int n = parse_list("/sys/devices/system/node/online", ids, MAX_NODES);
+
+    num_nodes = 0;
+    for (int i = 0; i < n; i++) {
+        char path[128];
+        int cpus[1];
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", ids[i]);
+        node_ids[num_nodes] = ids[i];
+        node_cpu[num_nodes] = parse_list(path, cpus, 1) == 1 ? cpus[0] : -1;
+        num_nodes++;
+    }
+
+    if (num_nodes == 0) {
+        node_ids[0] = 0;
+        node_cpu[0] = 0;
+        num_nodes = 1;
+    }
+}
+
+static long sys_mbind(void *addr, size_t len, int mode, const unsigned long *nodemask,
+                      unsigned long maxnode, unsigned flags) {
+    return syscall(SYS_mbind, addr, len, mode, nodemask, maxnode, flags);
+}
+
+// Map size bytes whose pages are bound to node, then fault them in.
+// If mbind is unavailable we fall back to first touch from the calling thread,
+// unless the node has no CPU to touch from: then *placed is cleared.
+static char *alloc_on_node(size_t size, int node, int has_cpu, int *placed) {
+    char *mem = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED) {
+        perror("mmap failed");
+        return NULL;
+    }
+
+    unsigned long mask[MAX_NODES / (8 * sizeof(unsigned long)) + 1] = { 0 };
+    mask[node / (8 * sizeof(unsigned long))] |= 1UL << (node % (8 * sizeof(unsigned long)));
+    *placed = 1;
+    if (sys_mbind(mem, size, MPOL_BIND, mask, MAX_NODES + 1,
+                  MPOL_MF_STRICT | MPOL_MF_MOVE) != 0) {
+        static int warned = 0;
+        if (!warned) {
+            printf("mbind failed (%s), using first-touch placement\n", strerror(errno));
+            warned = 1;
+        }
+        *placed = has_cpu;
+    }
+
+    memset(mem, 0, size);
+    return mem;
+}
+
+// One random cycle through all n nodes, following a random visiting order
+static int build_chase_cycle(chase_node_t *nodes, size_t n) {
+    size_t *order = malloc(n * sizeof(size_t));
+    if (!order) { perror("malloc order"); return -1; }
+    perm_random_order(order, n, PERM_SEED, 0);
+    for (size_t i = 0; i + 1 < n; i++) {
+        nodes[order[i]].next = order[i + 1];
+    }
+    nodes[order[n - 1]].next = order[0];
+    free(order);
+    return 0;
+}
+
+typedef struct {
+    char *mem;
+    size_t size;
+} cell_ctx_t;
+
+// Latency kernel: CHASE_LOADS dependent loads, in ms. The bench_repeat
+// warm-up runs lap the cycle first, so the first cell does not also pay for
+// TLB and page-walk warm-up.
+static double chase_run(void *arg) {
+    chase_node_t *nodes = (chase_node_t *)((cell_ctx_t *)arg)->mem;
+    size_t p = 0;
+
+    pc_region_begin();
+    double start = bench_now_ns();
+    for (size_t i = 0; i < CHASE_LOADS; i++) {
+        p = nodes[p].next;
+    }
+    double elapsed = bench_elapsed_ms(start);
+    pc_region_end();
+
+    if (p == (size_t)-1) printf("p=%zu\n", p);
+    return elapsed;
+}
+
+// Bandwidth kernel: one pass of sequential 64-bit reads, in ms
+static double read_run(void *arg) {
+    cell_ctx_t *ctx = (cell_ctx_t *)arg;
+    const long long *p = (const long long *)ctx->mem;
+    size_t n = ctx->size / sizeof(long long);
+    long long acc = 0;
+
+    pc_region_begin();
+    double start = bench_now_ns();
+    for (size_t i = 0; i < n; i++) {
+        acc += p[i];
+    }
+    double elapsed = bench_elapsed_ms(start);
+    pc_region_end();
+
+    if (acc == 42) printf("acc=%lld\n", acc);
+    return elapsed;
+}
+
+static void print_matrix(const char *title, const char *unit, double m[MAX_NODES][MAX_NODES]) {
+    printf("\n=== %s (%s) ===\n", title, unit);
+    printf("%12s", "cpu\\mem");
+    for (int x = 0; x < num_nodes; x++) {
+        char label[16];
+        snprintf(label, sizeof(label), "node %d", node_ids[x]);
+        printf(" %11s", label);
+    }
+    printf("\n");
+    for (int y = 0; y < num_nodes; y++) {
+        if (node_cpu[y] < 0) continue;
+        printf("   node %-4d", node_ids[y]);
+        for (int x = 0; x < num_nodes; x++) {
+            if (m[y][x] < 0) printf(" %11s", "-");
+            else printf(" %11.2f", m[y][x]);
+        }
+        printf("\n");
+    }
+}
+
+int main(int argc, char *argv[]) {
+    argc = bench_init(argc, argv, "numa_matrix");
+    argc = bench_stats_init(argc, argv);
+    size_t mb = argc >= 2 ? strtoull(argv[1], NULL, 10) : DEFAULT_MB;
+    size_t size = mb * 1024ULL * 1024ULL;
+    size_t n = size / sizeof(chase_node_t);
+    if (n < 2) {
+        printf("Usage: %s [mb_per_cell] [--format text|json|csv] [--warmup N] [--reps N]\n"
+               "        [--timer clock|tsc] [--counters]\n", argv[0]);
+        return 1;
+    }
+
+    discover_nodes();
+
+    printf("=== NUMA Placement Matrix ===\n");
+    printf("Nodes: %d, buffer per cell: %zu MB\n", num_nodes, mb);
+    for (int i = 0; i < num_nodes; i++) {
+        if (node_cpu[i] >= 0) printf("  node %d -> running on CPU %d\n", node_ids[i], node_cpu[i]);
+        else printf("  node %d -> memory only\n", node_ids[i]);
+    }
+    if (num_nodes == 1) {
+        printf("Single NUMA node: reporting local latency/bandwidth only\n");
+    }
+
+    static double latency[MAX_NODES][MAX_NODES];
+    static double bandwidth[MAX_NODES][MAX_NODES];
+    cpu_set_t all_cpus;
+    sched_getaffinity(0, sizeof(all_cpus), &all_cpus);
+
+    // Memory on node X, kernels on node Y
+    for (int x = 0; x < num_nodes; x++) {
+        for (int y = 0; y < num_nodes; y++) latency[y][x] = bandwidth[y][x] = -1;
+
+        // Touch from node X too, so first-touch fallback lands on the right node
+        int placed;
+        if (node_cpu[x] >= 0) bind_thread_to_core(node_cpu[x]);
+        char *mem = alloc_on_node(size, node_ids[x], node_cpu[x] >= 0, &placed);
+        if (!mem) return 1;
+        if (!placed) {
+            printf("mem node %d: memory-only and mbind failed, skipped\n", node_ids[x]);
+            munmap(mem, size);
+            continue;
+        }
+        // Restore the full mask: perm_random_order's threads inherit it
+        sched_setaffinity(0, sizeof(all_cpus), &all_cpus);
+        if (build_chase_cycle((chase_node_t *)mem, n) != 0) return 1;
+
+        for (int y = 0; y < num_nodes; y++) {
+            if (node_cpu[y] < 0) continue;
+            bind_thread_to_core(node_cpu[y]);
+            cell_ctx_t ctx = { mem, size };
+            bench_result_t lat_res, bw_res;
+            bench_repeat(chase_run, &ctx, &lat_res);
+            bench_repeat(read_run, &ctx, &bw_res);
+            latency[y][x] = lat_res.median_ms * 1e6 / CHASE_LOADS;
+            bandwidth[y][x] = size / (bw_res.median_ms * 1e6);
+            printf("mem node %d, cpu node %d: %.2f ns/load, %.2f GB/s (medians of %d)\n",
+                   node_ids[x], node_ids[y], latency[y][x], bandwidth[y][x], bench_reps);
+            bench_report_stats("numa_latency", &lat_res, CHASE_LOADS, 0,
+                               "mem_node=%d,cpu_node=%d,size_bytes=%zu", node_ids[x], node_ids[y], size);
+            bench_report_stats("numa_bandwidth", &bw_res, 0, size,
+                               "mem_node=%d,cpu_node=%d,size_bytes=%zu", node_ids[x], node_ids[y], size);
+        }
+        munmap(mem, size);
+        sched_setaffinity(0, sizeof(all_cpus), &all_cpus);
+    }
+
+    print_matrix("Load Latency", "ns/load", latency);
+    print_matrix("Read Bandwidth", "GB/s", bandwidth);
+
+    if (num_nodes > 1) {
+        printf("\nRemote penalty (vs local on the CPU's node):\n");
+        for (int y = 0; y < num_nodes; y++) {
+            if (node_cpu[y] < 0 || latency[y][y] <= 0) continue;
+            for (int x = 0; x < num_nodes; x++) {
+                if (x == y || latency[y][x] < 0) continue;
+                printf("  cpu node %d -> mem node %d: %.2fx latency, %.2fx bandwidth\n",
+                       node_ids[y], node_ids[x],
+                       latency[y][x] / latency[y][y], bandwidth[y][x] / bandwidth[y][y]);
+            }
+        }
+    }
+    return 0;
+}
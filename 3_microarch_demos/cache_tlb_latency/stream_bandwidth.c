@@ -0,0 +1,259 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../common/bench_stats.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#define DEFAULT_MB 256              // Size of each of the three arrays
+#define CACHE_LINE_SIZE 64
+#define TRIAD_SCALAR 3.0
+
+typedef double (*read_fn)(const double *a, size_t n);
+typedef void (*write_fn)(double *a, size_t n, double v);
+typedef void (*copy_fn)(double *dst, const double *src, size_t n);
+typedef void (*triad_fn)(double *a, const double *b, const double *c, double s, size_t n);
+
+// One set of streaming kernels per ISA level. NT entries use non-temporal
+// stores and are NULL where the ISA has no streaming store.
+typedef struct {
+    const char *name;
+    int available;
+    read_fn read;
+    write_fn write, write_nt;
+    copy_fn copy, copy_nt;
+    triad_fn triad, triad_nt;
+} isa_kernels_t;
+
+// ---- Scalar baseline (kept scalar so the compiler does not vectorize it) ----
+
+#define SCALAR __attribute__((noinline, optimize("no-tree-vectorize")))
+
+SCALAR static double read_scalar(const double *a, size_t n) {
+    double s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    for (size_t i = 0; i < n; i += 4) {
+        s0 += a[i]; s1 += a[i + 1]; s2 += a[i + 2]; s3 += a[i + 3];
+    }
+    return s0 + s1 + s2 + s3;
+}
+
+SCALAR static void write_scalar(double *a, size_t n, double v) {
+    for (size_t i = 0; i < n; i++) a[i] = v;
+}
+
+SCALAR static void copy_scalar(double *dst, const double *src, size_t n) {
+    for (size_t i = 0; i < n; i++) dst[i] = src[i];
+}
+
+SCALAR static void triad_scalar(double *a, const double *b, const double *c, double s, size_t n) {
+    for (size_t i = 0; i < n; i++) a[i] = b[i] + s * c[i];
+}
+
+// ---- x86: SSE2 / AVX2 / AVX-512, compiled with per-function target attributes ----
+
+#if defined(__x86_64__) || defined(__i386__)
+
+// Stamp out read/write/copy/triad (+NT variants) for one vector width.
+// n is always a multiple of CACHE_LINE_SIZE / sizeof(double).
+#define DEFINE_X86_KERNELS(SFX, TGT, VT, W, LOAD, STORE, STREAM, ADD, MUL, SET1, ZERO)   \
+__attribute__((target(TGT))) static double read_##SFX(const double *a, size_t n) {       \
+    VT s0 = ZERO(), s1 = ZERO();                                                         \
+    for (size_t i = 0; i < n; i += 2 * (W)) {                                            \
+        s0 = ADD(s0, LOAD(a + i));                                                       \
+        s1 = ADD(s1, LOAD(a + i + (W)));                                                 \
+    }                                                                                    \
+    double lanes[W] __attribute__((aligned(CACHE_LINE_SIZE)));                           \
+    STORE(lanes, ADD(s0, s1));                                                           \
+    double sum = 0;                                                                      \
+    for (int l = 0; l < (W); l++) sum += lanes[l];                                       \
+    return sum;                                                                          \
+}                                                                                        \
+__attribute__((target(TGT))) static void write_##SFX(double *a, size_t n, double v) {    \
+    VT x = SET1(v);                                                                      \
+    for (size_t i = 0; i < n; i += (W)) STORE(a + i, x);                                 \
+}                                                                                        \
+__attribute__((target(TGT))) static void write_nt_##SFX(double *a, size_t n, double v) { \
+    VT x = SET1(v);                                                                      \
+    for (size_t i = 0; i < n; i += (W)) STREAM(a + i, x);                                \
+    _mm_sfence();                                                                        \
+}                                                                                        \
+__attribute__((target(TGT))) static void copy_##SFX(double *dst, const double *src, size_t n) { \
+    for (size_t i = 0; i < n; i += (W)) STORE(dst + i, LOAD(src + i));                   \
+}                                                                                        \
+__attribute__((target(TGT))) static void copy_nt_##SFX(double *dst, const double *src, size_t n) { \
+    for (size_t i = 0; i < n; i += (W)) STREAM(dst + i, LOAD(src + i));                  \
+    _mm_sfence();                                                                        \
+}                                                                                        \
+__attribute__((target(TGT))) static void triad_##SFX(double *a, const double *b,         \
+                                                     const double *c, double s, size_t n) { \
+    VT vs = SET1(s);                                                                     \
+    for (size_t i = 0; i < n; i += (W))                                                  \
+        STORE(a + i, ADD(LOAD(b + i), MUL(vs, LOAD(c + i))));                            \
+}                                                                                        \
+__attribute__((target(TGT))) static void triad_nt_##SFX(double *a, const double *b,      \
+                                                        const double *c, double s, size_t n) { \
+    VT vs = SET1(s);                                                                     \
+    for (size_t i = 0; i < n; i += (W))                                                  \
+        STREAM(a + i, ADD(LOAD(b + i), MUL(vs, LOAD(c + i))));                           \
+    _mm_sfence();                                                                        \
+}
+
+DEFINE_X86_KERNELS(sse2, "sse2", __m128d, 2, _mm_load_pd, _mm_store_pd, _mm_stream_pd,
+                   _mm_add_pd, _mm_mul_pd, _mm_set1_pd, _mm_setzero_pd)
+DEFINE_X86_KERNELS(avx2, "avx2", __m256d, 4, _mm256_load_pd, _mm256_store_pd, _mm256_stream_pd,
+                   _mm256_add_pd, _mm256_mul_pd, _mm256_set1_pd, _mm256_setzero_pd)
+DEFINE_X86_KERNELS(avx512, "avx512f", __m512d, 8, _mm512_load_pd, _mm512_store_pd, _mm512_stream_pd,
+                   _mm512_add_pd, _mm512_mul_pd, _mm512_set1_pd, _mm512_setzero_pd)
+
+#define X86_KERNELS(NAME, SFX, FEATURE)                                          \
+    { NAME, FEATURE, read_##SFX, write_##SFX, write_nt_##SFX, copy_##SFX,        \
+      copy_nt_##SFX, triad_##SFX, triad_nt_##SFX }
+
+#endif
+
+// ---- arm64: NEON (baseline on AArch64, no streaming-store intrinsic) ----
+
+#if defined(__aarch64__)
+
+static double read_neon(const double *a, size_t n) {
+    float64x2_t s0 = vdupq_n_f64(0), s1 = vdupq_n_f64(0);
+    for (size_t i = 0; i < n; i += 4) {
+        s0 = vaddq_f64(s0, vld1q_f64(a + i));
+        s1 = vaddq_f64(s1, vld1q_f64(a + i + 2));
+    }
+    return vaddvq_f64(vaddq_f64(s0, s1));
+}
+
+static void write_neon(double *a, size_t n, double v) {
+    float64x2_t x = vdupq_n_f64(v);
+    for (size_t i = 0; i < n; i += 2) vst1q_f64(a + i, x);
+}
+
+static void copy_neon(double *dst, const double *src, size_t n) {
+    for (size_t i = 0; i < n; i += 2) vst1q_f64(dst + i, vld1q_f64(src + i));
+}
+
+static void triad_neon(double *a, const double *b, const double *c, double s, size_t n) {
+    float64x2_t vs = vdupq_n_f64(s);
+    for (size_t i = 0; i < n; i += 2)
+        vst1q_f64(a + i, vfmaq_f64(vld1q_f64(b + i), vs, vld1q_f64(c + i)));
+}
+
+#endif
+
+typedef enum { K_READ, K_WRITE, K_WRITE_NT, K_COPY, K_COPY_NT, K_TRIAD, K_TRIAD_NT } kernel_t;
+
+static const char *const kernel_names[] = {
+    "read", "write", "write-nt", "copy", "copy-nt", "triad", "triad-nt",
+};
+
+typedef struct {
+    const isa_kernels_t *isa;
+    kernel_t kernel;
+    double *a, *b, *c;
+    size_t n;
+} stream_ctx_t;
+
+static volatile double sink;
+
+// One call of one kernel, in ms
+static double stream_run(void *arg) {
+    stream_ctx_t *ctx = (stream_ctx_t *)arg;
+    const isa_kernels_t *isa = ctx->isa;
+    double *a = ctx->a, *b = ctx->b, *c = ctx->c;
+    size_t n = ctx->n;
+
+    pc_region_begin();
+    double start = bench_now_ns();
+    switch (ctx->kernel) {
+    case K_READ:     sink += isa->read(a, n); break;
+    case K_WRITE:    isa->write(a, n, 1.0); break;
+    case K_WRITE_NT: isa->write_nt(a, n, 1.0); break;
+    case K_COPY:     isa->copy(a, b, n); break;
+    case K_COPY_NT:  isa->copy_nt(a, b, n); break;
+    case K_TRIAD:    isa->triad(a, b, c, TRIAD_SCALAR, n); break;
+    case K_TRIAD_NT: isa->triad_nt(a, b, c, TRIAD_SCALAR, n); break;
+    }
+    double elapsed = bench_elapsed_ms(start);
+    pc_region_end();
+    return elapsed;
+}
+
+// Time one kernel with bench_repeat and print its median bandwidth
+static void run_kernel(stream_ctx_t *ctx, kernel_t kernel, double bytes) {
+    bench_result_t res;
+    ctx->kernel = kernel;
+    bench_repeat(stream_run, ctx, &res);
+    printf("%-10s %-12s %12.2f %12.2f\n", ctx->isa->name, kernel_names[kernel],
+           bytes / (res.median_ms * 1e6), res.mad_ms / res.median_ms * 100);
+    bench_report_stats(kernel_names[kernel], &res, 0, bytes, "isa=%s", ctx->isa->name);
+}
+
+int main(int argc, char *argv[]) {
+    argc = bench_init(argc, argv, "stream_bandwidth");
+    argc = bench_stats_init(argc, argv);
+    size_t mb = argc >= 2 ? strtoull(argv[1], NULL, 10) : DEFAULT_MB;
+    size_t bytes = mb * 1024ULL * 1024ULL;
+    size_t n = bytes / sizeof(double);
+    n -= n % (CACHE_LINE_SIZE / sizeof(double));
+    if (n == 0) {
+        printf("Usage: %s [mb_per_array] [--format text|json|csv] [--warmup N] [--reps N]\n"
+               "        [--timer clock|tsc] [--counters]\n", argv[0]);
+        return 1;
+    }
+    bytes = n * sizeof(double);
+
+    double *a = aligned_alloc(CACHE_LINE_SIZE, bytes);
+    double *b = aligned_alloc(CACHE_LINE_SIZE, bytes);
+    double *c = aligned_alloc(CACHE_LINE_SIZE, bytes);
+    if (!a || !b || !c) { perror("aligned_alloc"); return 1; }
+    for (size_t i = 0; i < n; i++) {
+        a[i] = 1.0; b[i] = 2.0; c[i] = 0.5;
+    }
+
+    isa_kernels_t isas[] = {
+        { "scalar", 1, read_scalar, write_scalar, NULL, copy_scalar, NULL, triad_scalar, NULL },
+#if defined(__x86_64__) || defined(__i386__)
+        X86_KERNELS("sse2", sse2, __builtin_cpu_supports("sse2")),
+        X86_KERNELS("avx2", avx2, __builtin_cpu_supports("avx2")),
+        X86_KERNELS("avx512", avx512, __builtin_cpu_supports("avx512f")),
+#elif defined(__aarch64__)
+        { "neon", 1, read_neon, write_neon, NULL, copy_neon, NULL, triad_neon, NULL },
+#endif
+    };
+    const int num_isas = sizeof(isas) / sizeof(isas[0]);
+
+    printf("=== Streaming Bandwidth Kernels ===\n");
+    printf("Array size: %.2f MB x 3, median of %d runs after %d warm-up\n\n",
+           bytes / 1024.0 / 1024.0, bench_reps, bench_warmup);
+    printf("%-10s %-12s %12s %12s\n", "ISA", "Kernel", "GB/s", "MAD %");
+
+    for (int k = 0; k < num_isas; k++) {
+        isa_kernels_t *isa = &isas[k];
+        if (!isa->available) {
+            printf("%-10s (not supported by this CPU)\n", isa->name);
+            continue;
+        }
+
+        stream_ctx_t ctx = { isa, K_READ, a, b, c, n };
+        run_kernel(&ctx, K_READ, bytes);
+        run_kernel(&ctx, K_WRITE, bytes);
+        if (isa->write_nt) run_kernel(&ctx, K_WRITE_NT, bytes);
+        run_kernel(&ctx, K_COPY, 2.0 * bytes);
+        if (isa->copy_nt) run_kernel(&ctx, K_COPY_NT, 2.0 * bytes);
+        run_kernel(&ctx, K_TRIAD, 3.0 * bytes);
+        if (isa->triad_nt) run_kernel(&ctx, K_TRIAD_NT, 3.0 * bytes);
+    }
+
+    // Write and copy kernels count only program-visible bytes; without NT
+    // stores the hardware also reads each destination line (RFO)
+    printf("\nBytes counted STREAM-style: read=1x, write=1x, copy=2x, triad=3x array size\n");
+
+    free(a); free(b); free(c);
+    return 0;
+}
@@ -2,15 +2,26 @@
 
 echo "=== Comprehensive TLB Performance Analysis ==="
 
-gcc -O2 tlb_miss_demo.c -o tlb_miss_demo
+gcc -O2 -pthread tlb_miss_demo.c -o tlb_miss_demo -lm
 
 echo "1. Testing 4KB pages with comprehensive perf counters"
 sudo perf stat -e dTLB-loads,dTLB-load-misses,dTLB-stores,dTLB-store-misses,iTLB-loads,iTLB-load-misses,cache-misses,cache-references,instructions,cycles \
-    ./tlb_miss_demo 4k 2>&1 | tee perf_4k.log
+    ./tlb_miss_demo 4k --counters --format json 2>&1 >tlb_4k.jsonl | tee perf_4k.log
 
-echo -e "\n2. Testing 2MB huge pages with comprehensive perf counters"  
+echo -e "\n2. Testing 2MB huge pages (THP) with comprehensive perf counters"  
 sudo perf stat -e dTLB-loads,dTLB-load-misses,dTLB-stores,dTLB-store-misses,iTLB-loads,iTLB-load-misses,cache-misses,cache-references,instructions,cycles \
-    ./tlb_miss_demo 2m 2>&1 | tee perf_2m.log
+    ./tlb_miss_demo thp --counters --format json 2>&1 >tlb_2m.jsonl | tee perf_2m.log
+
+echo -e "\n3. Page-size sweep: 4K vs THP vs 2M hugetlb vs 1G hugetlb"
+echo "   (hugetlb modes need reserved pages, e.g. echo 2 > /sys/kernel/mm/hugepages/hugepages-1048576kB/nr_hugepages)"
+./tlb_miss_demo sweep --counters --format json >tlb_sweep.jsonl
+
+echo -e "\n4. TLB reach: pages touched x stride, 4K and THP"
+./tlb_miss_demo reach 4k --counters --format json >tlb_reach.jsonl
+./tlb_miss_demo reach thp --counters --format json >>tlb_reach.jsonl
+
+echo -e "\n5. First-touch cost: fault vs MAP_POPULATE vs MADV_POPULATE_WRITE vs parallel"
+./tlb_miss_demo populate --format json >tlb_populate.jsonl
 
 echo -e "\n=== Performance Analysis ==="
 
@@ -148,3 +159,4 @@ echo "• IPC improvement indicates better CPU utilization"
 echo "• Overall performance gain validates HugePage adoption"
 
 echo -e "\n[INFO] Raw perf logs: perf_4k.log, perf_2m.log"
+echo "[INFO] Benchmark records (JSON lines, hot-loop counters only): tlb_4k.jsonl, tlb_2m.jsonl, tlb_sweep.jsonl, tlb_reach.jsonl, tlb_populate.jsonl"
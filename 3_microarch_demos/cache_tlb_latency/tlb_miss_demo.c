@@ -1,25 +1,37 @@
 #define _GNU_SOURCE
+#include <errno.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
+#include <pthread.h>
 #include <sys/mman.h>
+#include <sys/resource.h>
 #include <time.h>
 #include <string.h>
+#include "../common/bench_stats.h"
+#include "../common/perm.h"
+#include "../common/hugepage_arena.h"
 
 #define SIZE_GB 1          // Further reduce to 1GB
 #define PAGE_SIZE 4096     
 #define HUGE_PAGE_SIZE (2*1024*1024)  // 2MB huge pages
+#define GIGA_PAGE_SIZE (1024*1024*1024UL)  // 1GB huge pages
 #define ITERATIONS 100000             // Much fewer iterations - 100K should be enough
+#define CACHE_LINE_SIZE 64
+#define REACH_MIN_PAGES 4
+#define REACH_LOADS (1 << 22)         // Dependent loads per reach cell
+#define REACH_SEED 0x71B5EEDULL
 
 // Pure TLB stress test - designed to maximize TLB misses
 double tlb_stress_test(char *arr, size_t size, const char* test_name) {
     volatile char sum = 0;
-    struct timespec start, end;
     size_t num_pages = size / PAGE_SIZE;
     
     printf("%s: Testing %zu pages...\n", test_name, num_pages);
     
-    clock_gettime(CLOCK_MONOTONIC, &start);
+    pc_region_begin();
+    double start = bench_now_ns();
     
     // Access pattern designed to stress TLB
     for (int iter = 0; iter < ITERATIONS; iter++) {
@@ -34,15 +46,24 @@ double tlb_stress_test(char *arr, size_t size, const char* test_name) {
         }
     }
     
-    clock_gettime(CLOCK_MONOTONIC, &end);
-    
-    double elapsed = (end.tv_sec - start.tv_sec) * 1e3 + 
-                    (end.tv_nsec - start.tv_nsec) / 1e6;
+    double elapsed = bench_elapsed_ms(start);
+    pc_region_end();
     
     printf("%s: Completed in %.2f ms (sum=%d)\n", test_name, elapsed, sum);
     return elapsed;
 }
 
+typedef struct {
+    char *arr;
+    size_t size;
+    const char *test_name;
+} tlb_ctx_t;
+
+static double tlb_stress_run(void *arg) {
+    tlb_ctx_t *ctx = (tlb_ctx_t *)arg;
+    return tlb_stress_test(ctx->arr, ctx->size, ctx->test_name);
+}
+
 void check_hugepage_config() {
     FILE *f = fopen("/proc/meminfo", "r");
     char line[256];
@@ -57,60 +78,398 @@ void check_hugepage_config() {
     printf("\n");
 }
 
-int main(int argc, char *argv[]) {
-    if (argc != 2) {
-        printf("Usage: %s [4k|2m]\n", argv[0]);
-        return 1;
-    }
-    
-    int use_hugepage = (strcmp(argv[1], "2m") == 0);
-    size_t size = SIZE_GB * 1024ULL * 1024ULL * 1024ULL;
-    
-    printf("=== TLB Test: %s ===\n", use_hugepage ? "2MB Pages" : "4KB Pages");
-    printf("Memory size: %zu GB, Iterations: %d\n\n", SIZE_GB, ITERATIONS);
-    
-    check_hugepage_config();
-    
-    char *memory = mmap(NULL, size, PROT_READ | PROT_WRITE,
-                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
-    if (memory == MAP_FAILED) {
+// One way of backing the test buffer. hugetlb modes never fall back: if the
+// pool cannot supply the pages the mode is reported as unavailable.
+typedef struct {
+    const char *name;           // Command-line mode
+    const char *label;
+    arena_pages_t pages;
+    size_t page_size;           // Rounding of the buffer size
+} page_mode_t;
+
+static const page_mode_t page_modes[] = {
+    { "4k",  "Normal 4KB pages",       ARENA_PAGES_4K,  PAGE_SIZE },
+    { "thp", "Transparent huge pages", ARENA_PAGES_THP, HUGE_PAGE_SIZE },
+    { "2m",  "HugeTLB 2MB pages",      ARENA_PAGES_2M,  HUGE_PAGE_SIZE },
+    { "1g",  "HugeTLB 1GB pages",      ARENA_PAGES_1G,  GIGA_PAGE_SIZE },
+};
+#define NUM_PAGE_MODES (int)(sizeof(page_modes) / sizeof(page_modes[0]))
+
+// mmap size bytes for the mode (see arena_map). extra_flags is OR-ed into the
+// mapping (e.g. MAP_POPULATE). Returns NULL if the mode is unavailable.
+char *map_buffer(const page_mode_t *mode, size_t size, int extra_flags) {
+    char *p = arena_map(mode->pages, size, extra_flags);
+    if (!p && (mode->pages == ARENA_PAGES_2M || mode->pages == ARENA_PAGES_1G)) {
+        printf("%s: mmap failed (%s); reserve pages via "
+               "/sys/kernel/mm/hugepages/hugepages-%zukB/nr_hugepages\n",
+               mode->label, strerror(errno), mode->page_size / 1024);
+    } else if (!p) {
         perror("mmap failed");
-        return 1;
     }
-    
-    if (use_hugepage) {
-        // Try explicit huge pages first
-        char *huge = mmap(NULL, size, PROT_READ | PROT_WRITE,
-                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_POPULATE, 
-                         -1, 0);
-        
-        if (huge == MAP_FAILED) {
-            printf("HugePage allocation failed, using THP...\n");
-            // Force transparent huge pages
-            if (madvise(memory, size, MADV_HUGEPAGE) != 0) {
-                perror("madvise MADV_HUGEPAGE failed");
-            }
+    return p;
+}
+
+typedef struct {
+    const page_mode_t *mode;
+    const char *obtained;
+    double median_ms;
+    double ns_per_access;
+} mode_result_t;
+
+// Map, touch and stress one page mode. Returns 0 on success, 1 if unavailable.
+int run_mode(const page_mode_t *mode, size_t size, mode_result_t *out) {
+    size = (size + mode->page_size - 1) & ~(mode->page_size - 1);
+
+    printf("\n=== TLB Test: %s ===\n", mode->label);
+    printf("Memory size: %.2f GB, Iterations: %d\n", size / 1024.0 / 1024.0 / 1024.0, ITERATIONS);
+
+    char *memory = map_buffer(mode, size, 0);
+    if (!memory) return 1;
+
+    // Initialize memory
+    memset(memory, 1, size);
+
+    arena_page_info_t info;
+    const char *obtained = "unknown";
+    if (arena_read_page_info(memory, &info) == 0) {
+        obtained = arena_backing_name(&info);
+        printf("Obtained: %s (KernelPageSize %zu kB, Rss %zu kB, AnonHugePages %zu kB, %.1f%% THP)\n",
+               obtained, info.kernel_page_kb, info.rss_kb, info.anon_huge_kb,
+               info.rss_kb ? 100.0 * info.anon_huge_kb / info.rss_kb : 0.0);
+    }
+    if (strcmp(obtained, mode->name) != 0) {
+        printf("Warning: requested %s but got %s pages\n", mode->name, obtained);
+    }
+
+    printf("Starting test...\n");
+    tlb_ctx_t ctx = { memory, size, mode->label };
+    bench_result_t res;
+    bench_repeat(tlb_stress_run, &ctx, &res);
+
+    double accesses = (double)ITERATIONS * ((size / PAGE_SIZE + 15) / 16);
+    printf("%s: ", mode->label);
+    bench_print_stats(&res);
+    bench_report_stats("tlb_stress", &res, accesses, 0,
+                       "pages=%s,backing=%s,kernel_page_kb=%zu,anon_huge_kb=%zu,size_bytes=%zu",
+                       mode->name, obtained, info.kernel_page_kb, info.anon_huge_kb, size);
+
+    out->mode = mode;
+    out->obtained = obtained;
+    out->median_ms = res.median_ms;
+    out->ns_per_access = res.median_ms * 1e6 / accesses;
+    munmap(memory, size);
+    return 0;
+}
+
+// ---- TLB reach sweep ----
+//
+// One dependent pointer chase over `pages` pages spaced `stride` pages apart,
+// visited in random order so neither the prefetchers nor the page-walk caches
+// see a regular pattern. Each page is hit at a different cache-line offset,
+// so the lines spread over all L1 sets and the data mostly stays cached: the
+// cost that grows with the page count is address translation. Reading the
+// table down a column, the steps mark the L1 dTLB, STLB and page-walk cache
+// capacities for that page size.
+
+static const size_t reach_strides[] = { 1, 2, 4, 16 };
+#define NUM_REACH_STRIDES (int)(sizeof(reach_strides) / sizeof(reach_strides[0]))
+
+typedef struct {
+    void **start;
+    size_t loads;
+} reach_ctx_t;
+
+// Link the pages into a single random cycle and return its start
+void **build_reach_chain(char *buf, size_t pages, size_t stride_bytes, size_t *order) {
+    perm_random_order(order, pages, REACH_SEED, 0);
+    void **slot = NULL, **first = NULL;
+    for (size_t i = 0; i < pages; i++) {
+        size_t page = order[i];
+        size_t offset = (page * CACHE_LINE_SIZE) % PAGE_SIZE;
+        void **next = (void **)(buf + page * stride_bytes + offset);
+        if (slot) *slot = next;
+        else first = next;
+        slot = next;
+    }
+    *slot = first;
+    return first;
+}
+
+// Timed with the cycle counter whatever --timer says, so that without
+// counters the cells can still be shown in ticks. The bench_repeat warm-up
+// runs fill the TLB and caches.
+static double reach_run(void *arg) {
+    reach_ctx_t *ctx = (reach_ctx_t *)arg;
+    void **p = ctx->start;
+
+    pc_region_begin();
+    uint64_t c0 = bench_cycle_counter();
+    for (size_t i = 0; i < ctx->loads; i++) p = (void **)*p;
+    uint64_t c1 = bench_cycle_counter();
+    pc_region_end();
+    if (p == NULL) printf("p=%p\n", (void *)p);
+
+    return (double)(c1 - c0) * bench_tsc_ns_per_tick / 1e6;
+}
+
+// Working-set (pages touched) x stride matrix for one page mode
+int run_reach_sweep(const page_mode_t *mode, size_t size) {
+    size = (size + mode->page_size - 1) & ~(mode->page_size - 1);
+    size_t max_pages = size / mode->page_size;
+
+    printf("\n=== TLB Reach Sweep: %s, %.2f GB buffer ===\n", mode->label,
+           size / 1024.0 / 1024.0 / 1024.0);
+    char *buf = map_buffer(mode, size, 0);
+    if (!buf) return 1;
+    memset(buf, 1, size);
+
+    arena_page_info_t info;
+    arena_read_page_info(buf, &info);
+    const char *obtained = arena_backing_name(&info);
+    printf("Obtained: %s (KernelPageSize %zu kB, AnonHugePages %zu kB)\n",
+           obtained, info.kernel_page_kb, info.anon_huge_kb);
+
+    size_t *order = malloc(max_pages * sizeof(size_t));
+    if (!order) { perror("malloc order"); munmap(buf, size); return 1; }
+
+    int have_counters = 0;
+    printf("Cells: median cycles/access (dTLB misses/access); cycles are %s\n\n",
+           pc_enabled ? "core cycles when counters open, else TSC ticks" : "TSC ticks (use --counters for core cycles and dTLB misses)");
+    printf("%10s %13s", "Pages", "Reach");
+    for (int s = 0; s < NUM_REACH_STRIDES; s++) printf("   stride=%-10zu", reach_strides[s]);
+    printf("\n");
+
+    for (size_t pages = REACH_MIN_PAGES; pages <= max_pages; pages *= 2) {
+        size_t reach = pages * mode->page_size;
+        if (reach >= (1UL << 30)) {
+            printf("%10zu %10zu GB", pages, reach >> 30);
+        } else if (reach >= (1UL << 20)) {
+            printf("%10zu %10zu MB", pages, reach >> 20);
         } else {
-            printf("Using explicit HugePages\n");
-            munmap(memory, size);
-            memory = huge;
+            printf("%10zu %10zu KB", pages, reach >> 10);
         }
-    } else {
-        // Explicitly prevent huge pages
-        if (madvise(memory, size, MADV_NOHUGEPAGE) != 0) {
-            perror("madvise NOHUGEPAGE failed");
+        for (int s = 0; s < NUM_REACH_STRIDES; s++) {
+            size_t stride_bytes = reach_strides[s] * mode->page_size;
+            if ((pages - 1) * stride_bytes + PAGE_SIZE > size) {
+                printf("   %-17s", "-");
+                continue;
+            }
+            reach_ctx_t ctx = { build_reach_chain(buf, pages, stride_bytes, order), REACH_LOADS };
+            bench_result_t res;
+            bench_repeat(reach_run, &ctx, &res);
+
+            // Median core cycles with counters, else the median run in ticks
+            const perf_sample_t *pc = &res.counters;
+            double cycles = pc->valid & (1u << PC_CYCLES)
+                                ? pc->count[PC_CYCLES] / REACH_LOADS
+                                : res.median_ms * 1e6 / bench_tsc_ns_per_tick / REACH_LOADS;
+            if (pc->valid & (1u << PC_DTLB_MISSES)) {
+                have_counters = 1;
+                printf("   %7.1f (%6.3f)", cycles, pc->count[PC_DTLB_MISSES] / REACH_LOADS);
+            } else {
+                printf("   %7.1f %9s", cycles, "");
+            }
+            fflush(stdout);
+            bench_report_stats("tlb_reach", &res, REACH_LOADS, 0,
+                               "pages=%s,backing=%s,pages_touched=%zu,stride_pages=%zu,"
+                               "cycles_per_access=%.2f",
+                               mode->name, obtained, pages, reach_strides[s], cycles);
         }
+        printf("\n");
     }
-    
-    // Initialize memory
-    memset(memory, 1, size);
-    
-    printf("Starting test...\n");
-    double elapsed = tlb_stress_test(memory, size, use_hugepage ? "Huge 2MB pages" : "Normal 4KB pages");
-    
+    if (!have_counters) printf("\n(no dTLB miss counts: hardware counters unavailable or --counters not given)\n");
+
+    free(order);
+    munmap(buf, size);
+    return 0;
+}
+
+// ---- First-touch / populate cost ----
+//
+// Times mmap plus getting every page of the buffer backed, the cost a process
+// pays to warm a fresh arena. munmap is outside the timed part.
+
+#define POPULATE_MAX_THREADS 256
+
+typedef enum {
+    POP_TOUCH,          // mmap, then write one byte per 4 KB from one thread
+    POP_MAP_POPULATE,   // mmap(MAP_POPULATE)
+    POP_MADVISE,        // mmap, then madvise(MADV_POPULATE_WRITE)
+    POP_PARALLEL,       // mmap, then write one byte per 4 KB from N threads
+    POP_NUM_METHODS,
+} populate_method_t;
+
+static const char *const populate_method_names[POP_NUM_METHODS] = {
+    "touch", "map_populate", "madv_populate_write", "parallel_touch",
+};
+
+typedef struct {
+    const page_mode_t *mode;
+    populate_method_t method;
+    size_t size;
+    int nthreads;
+    long faults;                // Minor + major faults of the last run
+    arena_page_info_t info;     // Backing obtained in the last run
+    int map_failed;             // Mode unavailable (e.g. hugetlb pool too small)
+    int method_failed;          // Method unsupported (MADV_POPULATE_WRITE needs Linux 5.14)
+} populate_ctx_t;
+
+typedef struct {
+    char *lo, *hi;
+} touch_slice_t;
+
+static void *touch_slice(void *arg) {
+    touch_slice_t *t = (touch_slice_t *)arg;
+    for (volatile char *p = t->lo; p < t->hi; p += PAGE_SIZE) *p = 1;
+    return NULL;
+}
+
+static long fault_count(void) {
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_minflt + ru.ru_majflt;
+}
+
+static double populate_run(void *arg) {
+    populate_ctx_t *ctx = (populate_ctx_t *)arg;
+    size_t size = ctx->size;
+    if (ctx->map_failed || ctx->method_failed) return 0;
+
+    long faults0 = fault_count();
+    double start = bench_now_ns();
+    char *buf = map_buffer(ctx->mode, size, ctx->method == POP_MAP_POPULATE ? MAP_POPULATE : 0);
+    if (!buf) {
+        ctx->map_failed = 1;
+        return 0;
+    }
+
+    if (ctx->method == POP_TOUCH) {
+        touch_slice_t t = { buf, buf + size };
+        touch_slice(&t);
+    } else if (ctx->method == POP_MADVISE) {
+        if (madvise(buf, size, MADV_POPULATE_WRITE) != 0) {
+            perror("madvise MADV_POPULATE_WRITE failed");
+            ctx->method_failed = 1;
+        }
+    } else if (ctx->method == POP_PARALLEL) {
+        pthread_t tids[POPULATE_MAX_THREADS];
+        touch_slice_t slices[POPULATE_MAX_THREADS];
+        size_t pages = size / PAGE_SIZE;
+        for (int i = 0; i < ctx->nthreads; i++) {
+            slices[i].lo = buf + pages * i / ctx->nthreads * PAGE_SIZE;
+            slices[i].hi = buf + pages * (i + 1) / ctx->nthreads * PAGE_SIZE;
+            pthread_create(&tids[i], NULL, touch_slice, &slices[i]);
+        }
+        for (int i = 0; i < ctx->nthreads; i++) pthread_join(tids[i], NULL);
+    }
+
+    double elapsed = bench_elapsed_ms(start);
+    ctx->faults = fault_count() - faults0;
+    arena_read_page_info(buf, &ctx->info);
+    munmap(buf, size);
+    return elapsed;
+}
+
+int run_populate(size_t size) {
+    int nthreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (nthreads > POPULATE_MAX_THREADS) nthreads = POPULATE_MAX_THREADS;
+
+    printf("\n=== Populate Cost: %.2f GB per mapping, %d threads for parallel_touch ===\n",
+           size / 1024.0 / 1024.0 / 1024.0, nthreads);
+    printf("%-6s %-20s %-9s %12s %10s %12s %12s\n",
+           "Mode", "Method", "Obtained", "Median (ms)", "GB/s", "Faults", "Faults/s");
+
+    for (int m = 0; m < NUM_PAGE_MODES; m++) {
+        const page_mode_t *mode = &page_modes[m];
+        size_t mode_size = (size + mode->page_size - 1) & ~(mode->page_size - 1);
+        for (int method = 0; method < POP_NUM_METHODS; method++) {
+            populate_ctx_t ctx = { mode, (populate_method_t)method, mode_size, nthreads, 0, { 0 }, 0, 0 };
+            bench_result_t res;
+            bench_repeat(populate_run, &ctx, &res);
+            if (ctx.map_failed || ctx.method_failed) {
+                printf("%-6s %-20s (unavailable)\n", mode->name, populate_method_names[method]);
+                if (ctx.map_failed) break;      // hugetlb pool too small: the other methods fail too
+                continue;
+            }
+
+            const char *obtained = arena_backing_name(&ctx.info);
+            double gbps = mode_size / (res.median_ms * 1e6);
+            double faults_per_s = ctx.faults / (res.median_ms / 1e3);
+            printf("%-6s %-20s %-9s %12.2f %10.2f %12ld %12.0f\n", mode->name,
+                   populate_method_names[method], obtained, res.median_ms, gbps, ctx.faults,
+                   faults_per_s);
+            bench_report_stats("populate", &res, (double)ctx.faults, (double)mode_size,
+                               "pages=%s,method=%s,backing=%s,threads=%d,faults=%ld,faults_per_s=%.0f,"
+                               "size_bytes=%zu",
+                               mode->name, populate_method_names[method], obtained,
+                               method == POP_PARALLEL ? nthreads : 1, ctx.faults, faults_per_s,
+                               mode_size);
+        }
+    }
+    printf("\nNote: MAP_POPULATE faults pages in before madvise(MADV_HUGEPAGE) can run,\n"
+           "so thp/map_populate only gets huge pages when THP is set to \"always\".\n");
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    argc = bench_init(argc, argv, "tlb_miss_demo");
+    argc = bench_stats_init(argc, argv);
+    if (argc < 2 || argc > 4 || (argc == 4 && strcmp(argv[1], "reach") != 0)) {
+        printf("Usage: %s [4k|thp|2m|1g|sweep] [size_mb] [--format text|json|csv] [--warmup N]\n"
+               "        [--reps N] [--timer clock|tsc] [--counters]\n"
+               "       %s reach [4k|thp|2m|1g] [size_mb]   pages-touched x stride matrix\n"
+               "       %s populate [size_mb]               first-touch / prefault cost\n",
+               argv[0], argv[0], argv[0]);
+        return 1;
+    }
+
+    if (strcmp(argv[1], "populate") == 0) {
+        size_t size = argc == 3 ? strtoull(argv[2], NULL, 10) * 1024ULL * 1024ULL
+                                : SIZE_GB * 1024ULL * 1024ULL * 1024ULL;
+        return size ? run_populate(size) : 1;
+    }
+
+    if (strcmp(argv[1], "reach") == 0) {
+        const char *name = argc >= 3 ? argv[2] : "4k";
+        size_t size = argc == 4 ? strtoull(argv[3], NULL, 10) * 1024ULL * 1024ULL
+                                : SIZE_GB * 1024ULL * 1024ULL * 1024ULL;
+        // The chase reports cycles, so the tick length is needed even with --timer clock
+        if (!bench_use_tsc) bench_calibrate_tsc();
+        for (int m = 0; m < NUM_PAGE_MODES; m++) {
+            if (strcmp(name, page_modes[m].name) == 0) return run_reach_sweep(&page_modes[m], size);
+        }
+        printf("Unknown page mode '%s'\n", name);
+        return 1;
+    }
+
+    size_t size = argc == 3 ? strtoull(argv[2], NULL, 10) * 1024ULL * 1024ULL
+                            : SIZE_GB * 1024ULL * 1024ULL * 1024ULL;
+    int sweep = strcmp(argv[1], "sweep") == 0;
+    int selected = -1;
+    for (int m = 0; m < NUM_PAGE_MODES; m++) {
+        if (strcmp(argv[1], page_modes[m].name) == 0) selected = m;
+    }
+    if ((!sweep && selected < 0) || size == 0) {
+        printf("Unknown mode '%s' or empty size\n", argv[1]);
+        return 1;
+    }
+
+    check_hugepage_config();
+
+    mode_result_t results[NUM_PAGE_MODES];
+    int nresults = 0;
+    for (int m = 0; m < NUM_PAGE_MODES; m++) {
+        if (!sweep && m != selected) continue;
+        if (run_mode(&page_modes[m], size, &results[nresults]) == 0) nresults++;
+    }
+    if (nresults == 0) return 1;
+
     printf("\n=== Results ===\n");
-    printf("%s: %.2f ms\n", use_hugepage ? "Huge 2MB" : "Normal 4KB", elapsed);
-    
-    munmap(memory, size);
+    printf("%-6s %-10s %14s %14s %10s\n", "Mode", "Obtained", "Median (ms)", "ns/access", "vs first");
+    for (int i = 0; i < nresults; i++) {
+        printf("%-6s %-10s %14.2f %14.3f %9.2fx\n", results[i].mode->name, results[i].obtained,
+               results[i].median_ms, results[i].ns_per_access,
+               results[0].median_ms / results[i].median_ms);
+    }
     return 0;
 }
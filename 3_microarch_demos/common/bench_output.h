@@ -0,0 +1,250 @@
+#ifndef BENCH_OUTPUT_H
+#define BENCH_OUTPUT_H
+
+// Machine-readable result records for the microarch demos.
+//
+// Each demo calls bench_init() first thing in main() and bench_report() once
+// per measured case. With the default "--format text" nothing changes. With
+// "--format json" (one JSON object per line) or "--format csv", records go to
+// stdout and all of the demo's human-readable printf output is moved to
+// stderr, so `./demo --format json > results.jsonl` captures records only.
+// "--counters" turns on the in-process hardware counters (perf_counters.h);
+// each record then carries the counter deltas of its timed region.
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/utsname.h>
+#include "perf_counters.h"
+
+typedef enum {
+    BENCH_FMT_TEXT,
+    BENCH_FMT_JSON,
+    BENCH_FMT_CSV,
+} bench_format_t;
+
+typedef struct {
+    const char *test;       // Case within the benchmark, e.g. "random_access"
+    const char *params;     // "key=value,key=value"
+    int samples;            // Measured runs kept after outlier rejection
+    int outliers;           // Runs rejected as outliers
+    double median_ms;       // Median (p50) time of one run
+    double p99_ms;
+    double mad_ms;          // Median absolute deviation
+    double ci_low_ms;       // 95% confidence interval of the median
+    double ci_high_ms;
+    double ops;             // Operations per run; <= 0 when not meaningful
+    double bytes;           // Bytes moved per run; <= 0 when not meaningful
+    perf_sample_t counters; // Per-run counter deltas of the timed region
+} bench_result_t;
+
+static bench_format_t bench_format = BENCH_FMT_TEXT;
+static const char *bench_name = "unknown";
+static FILE *bench_out;
+static int bench_header_done;
+static char bench_host[256];
+static char bench_cpu[256];
+static char bench_kernel[256];
+
+static inline void bench_collect_host_info(void) {
+    struct utsname u;
+    if (gethostname(bench_host, sizeof(bench_host)) != 0) strcpy(bench_host, "unknown");
+    if (uname(&u) == 0) {
+        snprintf(bench_kernel, sizeof(bench_kernel), "%s %s", u.release, u.machine);
+        snprintf(bench_cpu, sizeof(bench_cpu), "%s", u.machine);
+    }
+
+    FILE *f = fopen("/proc/cpuinfo", "r");
+    if (!f) return;
+    char line[512];
+    while (fgets(line, sizeof(line), f)) {
+        // x86 reports "model name", arm64 only has "CPU part"
+        if (strncmp(line, "model name", 10) == 0 || strncmp(line, "CPU part", 8) == 0) {
+            char *v = strchr(line, ':');
+            if (v) {
+                v++;
+                while (*v == ' ' || *v == '\t') v++;
+                v[strcspn(v, "\n")] = '\0';
+                snprintf(bench_cpu, sizeof(bench_cpu), "%s", v);
+            }
+            break;
+        }
+    }
+    fclose(f);
+}
+
+// Strip "--format X" / "--format=X" and "--counters" from argv and set up the
+// record stream.
+// Returns the new argc; unknown formats fall back to text with a warning.
+static inline int bench_init(int argc, char *argv[], const char *name) {
+    bench_name = name;
+    bench_out = stdout;
+
+    int out = 1;
+    for (int i = 1; i < argc; i++) {
+        const char *fmt = NULL;
+        if (strcmp(argv[i], "--counters") == 0) {
+            pc_enabled = 1;
+            continue;
+        } else if (strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+            fmt = argv[++i];
+        } else if (strncmp(argv[i], "--format=", 9) == 0) {
+            fmt = argv[i] + 9;
+        } else {
+            argv[out++] = argv[i];
+            continue;
+        }
+        if (strcmp(fmt, "json") == 0) {
+            bench_format = BENCH_FMT_JSON;
+        } else if (strcmp(fmt, "csv") == 0) {
+            bench_format = BENCH_FMT_CSV;
+        } else if (strcmp(fmt, "text") != 0) {
+            fprintf(stderr, "Unknown format '%s', using text\n", fmt);
+        }
+    }
+    argv[out] = NULL;
+
+    if (bench_format != BENCH_FMT_TEXT) {
+        bench_collect_host_info();
+        fflush(stdout);
+        int fd = dup(STDOUT_FILENO);
+        FILE *records = fd >= 0 ? fdopen(fd, "w") : NULL;
+        if (records) {
+            bench_out = records;
+            dup2(STDERR_FILENO, STDOUT_FILENO);
+        }
+    }
+    return out;
+}
+
+static inline void bench_json_string(const char *s) {
+    fputc('"', bench_out);
+    for (; *s; s++) {
+        if (*s == '"' || *s == '\\') fputc('\\', bench_out);
+        if ((unsigned char)*s >= 0x20) fputc(*s, bench_out);
+    }
+    fputc('"', bench_out);
+}
+
+static inline void bench_csv_string(const char *s) {
+    fputc('"', bench_out);
+    for (; *s; s++) {
+        if (*s == '"') fputc('"', bench_out);
+        fputc(*s, bench_out);
+    }
+    fputc('"', bench_out);
+}
+
+static inline void bench_json_number(const char *key, double v, int valid) {
+    fprintf(bench_out, ",\"%s\":", key);
+    if (valid) fprintf(bench_out, "%.6g", v);
+    else fputs("null", bench_out);
+}
+
+static inline double bench_ipc(const perf_sample_t *c) {
+    unsigned both = (1u << PC_CYCLES) | (1u << PC_INSTRUCTIONS);
+    if ((c->valid & both) != both || c->count[PC_CYCLES] <= 0) return 0;
+    return c->count[PC_INSTRUCTIONS] / c->count[PC_CYCLES];
+}
+
+static inline void bench_emit(const bench_result_t *r) {
+    if (bench_format == BENCH_FMT_TEXT) return;
+
+    double ns_per_op = r->ops > 0 ? r->median_ms * 1e6 / r->ops : 0;
+    double gb_per_s = r->bytes > 0 ? r->bytes / (r->median_ms * 1e6) : 0;
+    const char *params = r->params ? r->params : "";
+
+    if (bench_format == BENCH_FMT_JSON) {
+        fputs("{\"benchmark\":", bench_out);
+        bench_json_string(bench_name);
+        fputs(",\"test\":", bench_out);
+        bench_json_string(r->test);
+        fputs(",\"params\":", bench_out);
+        bench_json_string(params);
+        fprintf(bench_out, ",\"samples\":%d,\"outliers\":%d", r->samples, r->outliers);
+        bench_json_number("median_ms", r->median_ms, 1);
+        bench_json_number("p50_ms", r->median_ms, 1);
+        bench_json_number("p99_ms", r->p99_ms, 1);
+        bench_json_number("mad_ms", r->mad_ms, 1);
+        bench_json_number("ci95_low_ms", r->ci_low_ms, 1);
+        bench_json_number("ci95_high_ms", r->ci_high_ms, 1);
+        bench_json_number("ns_per_op", ns_per_op, r->ops > 0);
+        bench_json_number("gb_per_s", gb_per_s, r->bytes > 0);
+        if (r->counters.valid) {
+            for (int e = 0; e < PC_NUM_EVENTS; e++) {
+                bench_json_number(pc_event_names[e], r->counters.count[e],
+                                  r->counters.valid & (1u << e));
+            }
+            bench_json_number("ipc", bench_ipc(&r->counters), bench_ipc(&r->counters) > 0);
+        }
+        fputs(",\"host\":", bench_out);
+        bench_json_string(bench_host);
+        fputs(",\"cpu\":", bench_out);
+        bench_json_string(bench_cpu);
+        fputs(",\"kernel\":", bench_out);
+        bench_json_string(bench_kernel);
+        fputs("}\n", bench_out);
+    } else {
+        if (!bench_header_done) {
+            fputs("benchmark,test,params,samples,outliers,median_ms,p50_ms,p99_ms,"
+                  "mad_ms,ci95_low_ms,ci95_high_ms,ns_per_op,gb_per_s,cycles,instructions,"
+                  "l1d_misses,llc_misses,dtlb_misses,ipc,host,cpu,kernel\n",
+                  bench_out);
+            bench_header_done = 1;
+        }
+        bench_csv_string(bench_name);
+        fputc(',', bench_out);
+        bench_csv_string(r->test);
+        fputc(',', bench_out);
+        bench_csv_string(params);
+        fprintf(bench_out, ",%d,%d,%.6g,%.6g,%.6g,%.6g,%.6g,%.6g,", r->samples, r->outliers,
+                r->median_ms, r->median_ms, r->p99_ms, r->mad_ms, r->ci_low_ms, r->ci_high_ms);
+        if (r->ops > 0) fprintf(bench_out, "%.6g", ns_per_op);
+        fputc(',', bench_out);
+        if (r->bytes > 0) fprintf(bench_out, "%.6g", gb_per_s);
+        fputc(',', bench_out);
+        for (int e = 0; e < PC_NUM_EVENTS; e++) {
+            if (r->counters.valid & (1u << e)) fprintf(bench_out, "%.0f", r->counters.count[e]);
+            fputc(',', bench_out);
+        }
+        if (bench_ipc(&r->counters) > 0) fprintf(bench_out, "%.4g", bench_ipc(&r->counters));
+        fputc(',', bench_out);
+        bench_csv_string(bench_host);
+        fputc(',', bench_out);
+        bench_csv_string(bench_cpu);
+        fputc(',', bench_out);
+        bench_csv_string(bench_kernel);
+        fputc('\n', bench_out);
+    }
+    fflush(bench_out);
+}
+
+// Emit a single-run record. params is a printf-style "key=value,..." string.
+// The counters of the last timed region, if any, are attached and consumed.
+__attribute__((format(printf, 5, 6)))
+static inline void bench_report(const char *test, double elapsed_ms, double ops, double bytes,
+                                const char *params_fmt, ...) {
+    if (bench_format == BENCH_FMT_TEXT) return;
+
+    char params[512];
+    va_list ap;
+    va_start(ap, params_fmt);
+    vsnprintf(params, sizeof(params), params_fmt, ap);
+    va_end(ap);
+
+    bench_result_t r = {
+        .test = test, .params = params, .samples = 1,
+        .median_ms = elapsed_ms, .p99_ms = elapsed_ms,
+        .ci_low_ms = elapsed_ms, .ci_high_ms = elapsed_ms,
+        .ops = ops, .bytes = bytes, .counters = pc_last,
+    };
+    pc_last.valid = 0;
+    bench_emit(&r);
+}
+
+#endif
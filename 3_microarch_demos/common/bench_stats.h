@@ -0,0 +1,299 @@
+#ifndef BENCH_STATS_H
+#define BENCH_STATS_H
+
+// Repetition engine for the microarch demos: warmup runs, measured runs,
+// outlier rejection and robust statistics (median, MAD, 95% CI of the median).
+//
+// Command-line knobs, stripped from argv by bench_stats_init():
+//   --warmup N         unmeasured runs before measuring (default 1)
+//   --reps N           measured runs (default 5)
+//   --timer clock|tsc  CLOCK_MONOTONIC (default) or the CPU cycle counter
+//                      (rdtsc on x86, cntvct_el0 on arm64) scaled to ns
+
+#include <math.h>
+#include <sched.h>
+#include <stdint.h>
+#include <time.h>
+#include "bench_output.h"
+
+#define BENCH_MAX_REPS 1000
+#define BENCH_OUTLIER_MADS 3.0      // Reject |x - median| > 3 scaled MADs
+#define BENCH_SPIN_YIELD 256        // Empty polls before a spinning waiter yields
+#define BENCH_LAT_SAMPLES (1 << 14) // Last N latencies kept per thread ring
+
+static int bench_warmup = 1;
+static int bench_reps = 5;
+static int bench_use_tsc;
+static double bench_tsc_ns_per_tick;
+
+static inline uint64_t bench_clock_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static inline uint64_t bench_cycle_counter(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    uint32_t lo, hi;
+    __asm__ volatile("lfence\n\trdtsc" : "=a"(lo), "=d"(hi) :: "memory");
+    return ((uint64_t)hi << 32) | lo;
+#elif defined(__aarch64__)
+    uint64_t v;
+    __asm__ volatile("isb\n\tmrs %0, cntvct_el0" : "=r"(v) :: "memory");
+    return v;
+#else
+    return bench_clock_ns();
+#endif
+}
+
+// Ticks-to-ns factor for the cycle counter. x86 is calibrated against
+// CLOCK_MONOTONIC over ~50 ms; arm64 reads the counter frequency register.
+static inline void bench_calibrate_tsc(void) {
+#if defined(__aarch64__)
+    uint64_t freq;
+    __asm__ volatile("mrs %0, cntfrq_el0" : "=r"(freq));
+    bench_tsc_ns_per_tick = 1e9 / (double)freq;
+#elif defined(__x86_64__) || defined(__i386__)
+    uint64_t t0 = bench_clock_ns(), c0 = bench_cycle_counter();
+    while (bench_clock_ns() - t0 < 50000000ULL) {
+    }
+    uint64_t t1 = bench_clock_ns(), c1 = bench_cycle_counter();
+    bench_tsc_ns_per_tick = (double)(t1 - t0) / (double)(c1 - c0);
+#else
+    bench_tsc_ns_per_tick = 1.0;
+#endif
+}
+
+// Timestamp in ns from the selected timer; only differences are meaningful
+static inline double bench_now_ns(void) {
+    if (bench_use_tsc) return bench_cycle_counter() * bench_tsc_ns_per_tick;
+    return (double)bench_clock_ns();
+}
+
+static inline double bench_elapsed_ms(double start_ns) {
+    return (bench_now_ns() - start_ns) / 1e6;
+}
+
+// ---- Multi-threaded runs ----
+
+// Start and end of one thread's timed work. Workers stamp these themselves
+// after the start barrier; the unpinned main thread may wake late.
+typedef struct {
+    double start_ns, end_ns;
+} bench_span_t;
+
+static inline void bench_span_begin(bench_span_t *s) {
+    s->start_ns = bench_now_ns();
+}
+
+static inline void bench_span_end(bench_span_t *s) {
+    s->end_ns = bench_now_ns();
+}
+
+// ms from the earliest start to the latest end of n spans laid out stride
+// bytes apart (e.g. &workers[0].span, n, sizeof(workers[0]))
+static inline double bench_span_ms(const bench_span_t *first, int n, size_t stride) {
+    double start = first->start_ns, end = first->end_ns;
+    for (int i = 1; i < n; i++) {
+        const bench_span_t *s = (const bench_span_t *)((const char *)first + i * stride);
+        if (s->start_ns < start) start = s->start_ns;
+        if (s->end_ns > end) end = s->end_ns;
+    }
+    return (end - start) / 1e6;
+}
+
+static long bench_spin_yield_every = BENCH_SPIN_YIELD;
+
+// Call before starting threads: with more runnable threads than CPUs a
+// spinning waiter only burns the time slice its partner needs, so it
+// yields on every empty poll
+static inline void bench_spin_set_oversubscribed(int oversubscribed) {
+    bench_spin_yield_every = oversubscribed ? 1 : BENCH_SPIN_YIELD;
+}
+
+// One empty poll of a spin-wait; spins starts at 0 per wait
+static inline void bench_spin_pause(long *spins) {
+    if (++*spins >= bench_spin_yield_every) {
+        *spins = 0;
+        sched_yield();
+    }
+}
+
+// Store latency sample i (cycle-counter ticks) in a BENCH_LAT_SAMPLES ring
+static inline void bench_lat_record(uint32_t *ring, long i, uint64_t dt) {
+    ring[i & (BENCH_LAT_SAMPLES - 1)] = dt > UINT32_MAX ? UINT32_MAX : (uint32_t)dt;
+}
+
+// Append the kept samples of a ring that recorded count samples to
+// buf[0, nlat); rings may live inside buf further along. Returns the new nlat.
+static inline long bench_lat_append(uint32_t *buf, long nlat, const uint32_t *ring, long count) {
+    long kept = count < BENCH_LAT_SAMPLES ? count : BENCH_LAT_SAMPLES;
+    memmove(buf + nlat, ring, kept * sizeof(uint32_t));
+    return nlat + kept;
+}
+
+// Strip --warmup/--reps/--timer from argv. Returns the new argc.
+static inline int bench_stats_init(int argc, char *argv[]) {
+    int out = 1;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc) {
+            bench_warmup = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--reps") == 0 && i + 1 < argc) {
+            bench_reps = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--timer") == 0 && i + 1 < argc) {
+            bench_use_tsc = strcmp(argv[++i], "tsc") == 0;
+        } else {
+            argv[out++] = argv[i];
+        }
+    }
+    argv[out] = NULL;
+
+    if (bench_warmup < 0) bench_warmup = 0;
+    if (bench_reps < 1) bench_reps = 1;
+    if (bench_reps > BENCH_MAX_REPS) bench_reps = BENCH_MAX_REPS;
+    if (bench_use_tsc) bench_calibrate_tsc();
+    return out;
+}
+
+static inline int bench_cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// Value at quantile q of sorted[0, n) (nearest rank)
+static inline double bench_quantile(const double *sorted, int n, double q) {
+    int idx = (int)ceil(q * n) - 1;
+    if (idx < 0) idx = 0;
+    if (idx >= n) idx = n - 1;
+    return sorted[idx];
+}
+
+static inline int bench_cmp_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+// Latency samples are raw cycle-counter ticks whatever --timer says; make
+// sure the ticks-to-ns factor is calibrated before scaling them
+static inline void bench_tick_calibrate(void) {
+    if (bench_tsc_ns_per_tick == 0) bench_calibrate_tsc();
+}
+
+// Sort ticks[0, n) and store the nearest-rank value at each quantile q[i] in
+// out_ns[i], scaled to ns (q = 1 is the maximum). All zero when n is 0.
+static inline void bench_tick_quantiles(uint32_t *ticks, long n, const double *q, int nq,
+                                        double *out_ns) {
+    if (n > 0) qsort(ticks, n, sizeof(uint32_t), bench_cmp_u32);
+    for (int i = 0; i < nq; i++) {
+        long idx = (long)ceil(q[i] * n) - 1;
+        if (idx < 0) idx = 0;
+        if (idx >= n) idx = n - 1;
+        out_ns[i] = n > 0 ? ticks[idx] * bench_tsc_ns_per_tick : 0;
+    }
+}
+
+static inline double bench_median(const double *sorted, int n) {
+    return n % 2 ? sorted[n / 2] : 0.5 * (sorted[n / 2 - 1] + sorted[n / 2]);
+}
+
+// Fill median/MAD/p99/CI of r from samples[0, n). Samples further than
+// BENCH_OUTLIER_MADS scaled MADs from the median are dropped first. The CI is
+// the distribution-free order-statistic interval for the median (ranks
+// n/2 -+ 1.96*sqrt(n)/2), which needs no normality assumption.
+static inline void bench_compute_stats(double *samples, int n, bench_result_t *r) {
+    double dev[BENCH_MAX_REPS];
+
+    qsort(samples, n, sizeof(double), bench_cmp_double);
+    double med = bench_median(samples, n);
+    for (int i = 0; i < n; i++) dev[i] = fabs(samples[i] - med);
+    qsort(dev, n, sizeof(double), bench_cmp_double);
+    double mad = bench_median(dev, n);
+
+    int kept = 0;
+    for (int i = 0; i < n; i++) {
+        if (mad == 0 || fabs(samples[i] - med) <= BENCH_OUTLIER_MADS * 1.4826 * mad) {
+            samples[kept++] = samples[i];
+        }
+    }
+
+    r->samples = kept;
+    r->outliers = n - kept;
+    r->median_ms = bench_median(samples, kept);
+    r->p99_ms = bench_quantile(samples, kept, 0.99);
+    for (int i = 0; i < kept; i++) dev[i] = fabs(samples[i] - r->median_ms);
+    qsort(dev, kept, sizeof(double), bench_cmp_double);
+    r->mad_ms = bench_median(dev, kept);
+
+    double half = 1.96 * sqrt((double)kept) / 2.0;
+    int lo = (int)floor(kept / 2.0 - half);
+    int hi = (int)ceil(kept / 2.0 + half);
+    if (lo < 0) lo = 0;
+    if (hi > kept - 1) hi = kept - 1;
+    r->ci_low_ms = samples[lo];
+    r->ci_high_ms = samples[hi];
+}
+
+typedef double (*bench_run_fn)(void *ctx);   // One run; returns elapsed ms
+
+// Per-event median of the counter deltas of n runs; an event counts only if
+// every run produced it
+static inline void bench_median_counters(const perf_sample_t *runs, int n, perf_sample_t *out) {
+    double vals[BENCH_MAX_REPS];
+    memset(out, 0, sizeof(*out));
+    out->valid = n > 0 ? ~0u : 0;
+    for (int i = 0; i < n; i++) out->valid &= runs[i].valid;
+
+    for (int e = 0; e < PC_NUM_EVENTS; e++) {
+        if (!(out->valid & (1u << e))) continue;
+        for (int i = 0; i < n; i++) vals[i] = runs[i].count[e];
+        qsort(vals, n, sizeof(double), bench_cmp_double);
+        out->count[e] = bench_median(vals, n);
+    }
+    out->valid &= (1u << PC_NUM_EVENTS) - 1;
+}
+
+// Run fn bench_warmup times unmeasured, then bench_reps times, and summarize.
+// fn brackets its hot loop with pc_region_begin/end to get counters attached.
+static inline void bench_repeat(bench_run_fn fn, void *ctx, bench_result_t *r) {
+    double samples[BENCH_MAX_REPS];
+    static perf_sample_t counters[BENCH_MAX_REPS];
+    for (int i = 0; i < bench_warmup; i++) fn(ctx);
+    for (int i = 0; i < bench_reps; i++) {
+        pc_last.valid = 0;
+        samples[i] = fn(ctx);
+        counters[i] = pc_last;
+    }
+    pc_last.valid = 0;
+    bench_compute_stats(samples, bench_reps, r);
+    bench_median_counters(counters, bench_reps, &r->counters);
+}
+
+static inline void bench_print_stats(const bench_result_t *r) {
+    printf("Median: %.2f ms (MAD %.2f, 95%% CI [%.2f, %.2f], p99 %.2f, n=%d",
+           r->median_ms, r->mad_ms, r->ci_low_ms, r->ci_high_ms, r->p99_ms, r->samples);
+    if (r->outliers) printf(", %d outliers dropped", r->outliers);
+    printf(")\n");
+    perf_sample_print(&r->counters);
+}
+
+// Emit a repeated-measurement record. params is a printf-style string.
+__attribute__((format(printf, 5, 6)))
+static inline void bench_report_stats(const char *test, bench_result_t *r, double ops, double bytes,
+                                      const char *params_fmt, ...) {
+    if (bench_format == BENCH_FMT_TEXT) return;
+
+    char params[512];
+    va_list ap;
+    va_start(ap, params_fmt);
+    vsnprintf(params, sizeof(params), params_fmt, ap);
+    va_end(ap);
+
+    r->test = test;
+    r->params = params;
+    r->ops = ops;
+    r->bytes = bytes;
+    bench_emit(r);
+    r->params = NULL;
+}
+
+#endif
@@ -0,0 +1,410 @@
+#ifndef HUGEPAGE_ARENA_H
+#define HUGEPAGE_ARENA_H
+
+// Large-page arena: one big mapping, backed by hugetlb pages when the pool
+// has them and by THP otherwise, optionally bound to a NUMA node and
+// pre-faulted by pinned threads, then carved up with a lock-free bump
+// pointer. Objects are never freed individually; arena_reset() drops them all.
+//
+//   arena_opts_t opts = ARENA_OPTS_DEFAULT;
+//   arena_t *a = arena_create(8UL << 30, &opts);
+//   void *p = arena_alloc(a, bytes, 64);
+//   ...
+//   arena_destroy(a);
+//
+// Functions return NULL / -1 with errno set on failure and never exit.
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#ifndef MAP_HUGE_2MB
+#define MAP_HUGE_2MB (21 << MAP_HUGE_SHIFT)
+#endif
+#ifndef MAP_HUGE_1GB
+#define MAP_HUGE_1GB (30 << MAP_HUGE_SHIFT)
+#endif
+#ifndef MADV_POPULATE_WRITE
+#define MADV_POPULATE_WRITE 23      // Linux 5.14
+#endif
+
+// From <linux/mempolicy.h>; spelled out so the arena needs no libnuma
+#define ARENA_MPOL_BIND 2
+#define ARENA_MPOL_MF_MOVE (1 << 1)
+#define ARENA_MAX_NODES 1024
+#define ARENA_MAX_THREADS 256
+#define ARENA_BASE_PAGE 4096UL
+
+typedef enum {
+    ARENA_PAGES_4K,     // Base pages, THP disabled for the range
+    ARENA_PAGES_THP,    // Base mapping with MADV_HUGEPAGE
+    ARENA_PAGES_2M,     // hugetlb 2 MB pages
+    ARENA_PAGES_1G,     // hugetlb 1 GB pages
+} arena_pages_t;
+
+static const char *const arena_pages_names[] = { "4k", "thp", "2m", "1g" };
+
+typedef struct {
+    arena_pages_t pages;    // Preferred backing
+    int fallback;           // If hugetlb is unavailable, use THP instead of failing
+    int prefault_threads;   // 0 = one per usable CPU, < 0 = fault lazily on first touch
+    int numa_node;          // Bind pages (and prefault threads) to this node; -1 = no binding
+} arena_opts_t;
+
+#define ARENA_OPTS_DEFAULT { ARENA_PAGES_2M, 1, 0, -1 }
+
+// Page size the kernel actually used, from /proc/self/smaps
+typedef struct {
+    size_t kernel_page_kb;  // KernelPageSize of the VMA
+    size_t rss_kb;          // Rss, or Private_Hugetlb for hugetlb VMAs
+    size_t anon_huge_kb;    // AnonHugePages (THP-backed part of Rss)
+} arena_page_info_t;
+
+typedef struct {
+    size_t capacity;
+    size_t used;            // Bytes handed out since the last reset, incl. alignment
+    size_t peak;            // Highest used seen at a reset or stats call
+    unsigned long allocs;
+    unsigned long failed_allocs;
+    unsigned long resets;
+    arena_pages_t requested;
+    arena_pages_t mapped;   // Backing the mapping was created with after fallback
+    const char *obtained;   // What smaps reports: "4k", "thp", "2m" or "1g"
+    size_t kernel_page_kb;
+    size_t anon_huge_kb;
+    int numa_node;          // -1 when unbound or binding failed
+    int prefault_threads;
+    double prefault_ms;
+} arena_stats_t;
+
+typedef struct {
+    char *base;
+    size_t capacity;
+    size_t offset;          // Bump pointer, advanced with CAS
+    size_t peak;
+    unsigned long allocs;
+    unsigned long failed_allocs;
+    unsigned long resets;
+    arena_opts_t opts;
+    arena_pages_t mapped;
+    int numa_node;
+    int prefault_threads;
+    double prefault_ms;
+} arena_t;
+
+static inline size_t arena_page_size(arena_pages_t pages) {
+    switch (pages) {
+    case ARENA_PAGES_1G: return 1UL << 30;
+    case ARENA_PAGES_2M:
+    case ARENA_PAGES_THP: return 2UL << 20;
+    default: return ARENA_BASE_PAGE;
+    }
+}
+
+static inline size_t arena_round_up(size_t size, size_t align) {
+    return (size + align - 1) & ~(align - 1);
+}
+
+// mmap size bytes (a multiple of the page size) with the given backing.
+// Non-hugetlb mappings are aligned to 2 MB so THP can back the whole range;
+// extra_flags (e.g. MAP_POPULATE) apply to exactly size bytes. Returns NULL
+// with errno set, e.g. ENOMEM when the hugetlb pool is too small.
+static inline char *arena_map(arena_pages_t pages, size_t size, int extra_flags) {
+    if (pages == ARENA_PAGES_2M || pages == ARENA_PAGES_1G) {
+        int huge = MAP_HUGETLB | (pages == ARENA_PAGES_1G ? MAP_HUGE_1GB : MAP_HUGE_2MB);
+        char *p = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | huge | extra_flags, -1, 0);
+        return p == MAP_FAILED ? NULL : p;
+    }
+
+    // Reserve an oversized range, trim it to an aligned window, then map the
+    // window for real so flags like MAP_POPULATE only cover size bytes
+    size_t align = arena_page_size(ARENA_PAGES_THP);
+    size_t span = size + align;
+    char *raw = mmap(NULL, span, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (raw == MAP_FAILED) return NULL;
+    char *p = (char *)arena_round_up((uintptr_t)raw, align);
+    if (p > raw) munmap(raw, p - raw);
+    if (raw + span > p + size) munmap(p + size, raw + span - (p + size));
+    if (mmap(p, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED | extra_flags,
+             -1, 0) == MAP_FAILED) {
+        int err = errno;
+        munmap(p, size);
+        errno = err;
+        return NULL;
+    }
+
+    // Advice failures only cost page size, so they do not fail the mapping
+    madvise(p, size, pages == ARENA_PAGES_THP ? MADV_HUGEPAGE : MADV_NOHUGEPAGE);
+    return p;
+}
+
+static inline int arena_read_page_info(const void *addr, arena_page_info_t *info) {
+    memset(info, 0, sizeof(*info));
+    FILE *f = fopen("/proc/self/smaps", "r");
+    if (!f) return -1;
+
+    char line[256];
+    int in_vma = 0, found = 0;
+    uintptr_t a = (uintptr_t)addr;
+    while (fgets(line, sizeof(line), f)) {
+        uintptr_t lo, hi;
+        size_t kb;
+        if (sscanf(line, "%lx-%lx ", &lo, &hi) == 2 && strchr(line, '-') < strchr(line, ' ')) {
+            if (found) break;
+            in_vma = a >= lo && a < hi;
+            found = in_vma;
+        } else if (!in_vma) {
+            continue;
+        } else if (sscanf(line, "KernelPageSize: %zu kB", &kb) == 1) {
+            info->kernel_page_kb = kb;
+        } else if (sscanf(line, "Rss: %zu kB", &kb) == 1) {
+            info->rss_kb += kb;
+        } else if (sscanf(line, "Private_Hugetlb: %zu kB", &kb) == 1) {
+            info->rss_kb += kb;
+        } else if (sscanf(line, "AnonHugePages: %zu kB", &kb) == 1) {
+            info->anon_huge_kb = kb;
+        }
+    }
+    fclose(f);
+    return found ? 0 : -1;
+}
+
+// Short name of the backing actually obtained: 4k, thp, 2m or 1g
+static inline const char *arena_backing_name(const arena_page_info_t *info) {
+    if (info->kernel_page_kb >= 1024 * 1024) return "1g";
+    if (info->kernel_page_kb >= 2048) return "2m";
+    if (info->anon_huge_kb > 0) return "thp";
+    return "4k";
+}
+
+// Bind [addr, addr + size) to node with MPOL_BIND. Must run before the pages
+// are faulted in.
+static inline int arena_bind_node(void *addr, size_t size, int node) {
+    if (node < 0 || node >= ARENA_MAX_NODES) {
+        errno = EINVAL;
+        return -1;
+    }
+    unsigned long mask[ARENA_MAX_NODES / (8 * sizeof(unsigned long))] = { 0 };
+    mask[node / (8 * sizeof(unsigned long))] |= 1UL << (node % (8 * sizeof(unsigned long)));
+    return (int)syscall(SYS_mbind, addr, size, ARENA_MPOL_BIND, mask, ARENA_MAX_NODES + 1UL,
+                        ARENA_MPOL_MF_MOVE);
+}
+
+// CPUs usable for prefault threads: the node's CPUs if node >= 0, else the
+// process affinity mask. Returns the count written to cpus.
+static inline int arena_usable_cpus(int node, int *cpus, int max) {
+    int count = 0;
+    if (node >= 0) {
+        char path[128], buf[4096];
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+        FILE *f = fopen(path, "r");
+        if (f) {
+            if (fgets(buf, sizeof(buf), f)) {
+                for (char *tok = strtok(buf, ",\n"); tok && count < max; tok = strtok(NULL, ",\n")) {
+                    int lo, hi;
+                    if (sscanf(tok, "%d-%d", &lo, &hi) != 2) {
+                        if (sscanf(tok, "%d", &lo) != 1) continue;
+                        hi = lo;
+                    }
+                    for (int c = lo; c <= hi && count < max; c++) cpus[count++] = c;
+                }
+            }
+            fclose(f);
+        }
+        if (count > 0) return count;
+    }
+
+    cpu_set_t set;
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int c = 0; c < CPU_SETSIZE && count < max; c++) {
+            if (CPU_ISSET(c, &set)) cpus[count++] = c;
+        }
+    }
+    if (count == 0) cpus[count++] = 0;
+    return count;
+}
+
+typedef struct {
+    char *lo, *hi;
+} arena_slice_t;
+
+// Fault in one slice. MADV_POPULATE_WRITE does it in one call without a
+// user-space fault per page; older kernels fall back to touching each page.
+static inline void *arena_prefault_slice(void *arg) {
+    arena_slice_t *s = (arena_slice_t *)arg;
+    if (s->hi > s->lo && madvise(s->lo, s->hi - s->lo, MADV_POPULATE_WRITE) != 0) {
+        for (volatile char *p = s->lo; p < s->hi; p += ARENA_BASE_PAGE) *p = 0;
+    }
+    return NULL;
+}
+
+// Fault in [base, base + size) with nthreads threads (0 = one per usable CPU),
+// each pinned to its own CPU of node (or of the process mask if node < 0).
+// Slices are aligned to page_size. Returns the number of threads used.
+static inline int arena_prefault(char *base, size_t size, size_t page_size, int nthreads, int node) {
+    int cpus[ARENA_MAX_THREADS];
+    int ncpus = arena_usable_cpus(node, cpus, ARENA_MAX_THREADS);
+    size_t pages = size / page_size;
+    if (nthreads <= 0) nthreads = ncpus;
+    if (nthreads > ARENA_MAX_THREADS) nthreads = ARENA_MAX_THREADS;
+    if ((size_t)nthreads > pages) nthreads = pages > 0 ? (int)pages : 1;
+
+    pthread_t tids[ARENA_MAX_THREADS];
+    arena_slice_t slices[ARENA_MAX_THREADS];
+    int started[ARENA_MAX_THREADS];
+    for (int i = 0; i < nthreads; i++) {
+        slices[i].lo = base + pages * i / nthreads * page_size;
+        slices[i].hi = base + pages * (i + 1) / nthreads * page_size;
+
+        // Slice 0 runs on the calling thread; others are pinned at creation
+        started[i] = 0;
+        if (i == 0) continue;
+        pthread_attr_t attr;
+        cpu_set_t set;
+        pthread_attr_init(&attr);
+        CPU_ZERO(&set);
+        CPU_SET(cpus[i % ncpus], &set);
+        pthread_attr_setaffinity_np(&attr, sizeof(set), &set);
+        started[i] = pthread_create(&tids[i], &attr, arena_prefault_slice, &slices[i]) == 0;
+        pthread_attr_destroy(&attr);
+    }
+
+    arena_prefault_slice(&slices[0]);
+    for (int i = 1; i < nthreads; i++) {
+        if (started[i]) pthread_join(tids[i], NULL);
+        else arena_prefault_slice(&slices[i]);
+    }
+    return nthreads;
+}
+
+// Create an arena of at least size bytes. With opts NULL the defaults apply:
+// 2 MB hugetlb, THP fallback, prefault on all CPUs, no NUMA binding.
+static inline arena_t *arena_create(size_t size, const arena_opts_t *opts) {
+    arena_opts_t defaults = ARENA_OPTS_DEFAULT;
+    if (!opts) opts = &defaults;
+    if (size == 0) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    arena_t *a = calloc(1, sizeof(*a));
+    if (!a) return NULL;
+    a->opts = *opts;
+    a->mapped = opts->pages;
+    a->capacity = arena_round_up(size, arena_page_size(a->mapped));
+    a->base = arena_map(a->mapped, a->capacity, 0);
+
+    if (!a->base && opts->fallback && (a->mapped == ARENA_PAGES_2M || a->mapped == ARENA_PAGES_1G)) {
+        a->mapped = ARENA_PAGES_THP;
+        a->capacity = arena_round_up(size, arena_page_size(a->mapped));
+        a->base = arena_map(a->mapped, a->capacity, 0);
+    }
+    if (!a->base) {
+        int err = errno;
+        free(a);
+        errno = err;
+        return NULL;
+    }
+
+    a->numa_node = -1;
+    if (opts->numa_node >= 0 && arena_bind_node(a->base, a->capacity, opts->numa_node) == 0) {
+        a->numa_node = opts->numa_node;
+    }
+
+    if (opts->prefault_threads >= 0) {
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        a->prefault_threads = arena_prefault(a->base, a->capacity, arena_page_size(a->mapped),
+                                             opts->prefault_threads, a->numa_node);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        a->prefault_ms = (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6;
+    }
+    return a;
+}
+
+// Bump-allocate size bytes aligned to align (a power of two). Safe to call
+// from several threads. Returns NULL when the arena is exhausted.
+static inline void *arena_alloc(arena_t *a, size_t size, size_t align) {
+    if (align == 0) align = 1;
+    size_t old = __atomic_load_n(&a->offset, __ATOMIC_RELAXED);
+    size_t start, end;
+    do {
+        start = arena_round_up((uintptr_t)a->base + old, align) - (uintptr_t)a->base;
+        end = start + size;
+        if (end > a->capacity || end < start) {
+            __atomic_fetch_add(&a->failed_allocs, 1, __ATOMIC_RELAXED);
+            return NULL;
+        }
+    } while (!__atomic_compare_exchange_n(&a->offset, &old, end, 1,
+                                          __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+    __atomic_fetch_add(&a->allocs, 1, __ATOMIC_RELAXED);
+    return a->base + start;
+}
+
+static inline void arena_update_peak(arena_t *a) {
+    size_t used = __atomic_load_n(&a->offset, __ATOMIC_RELAXED);
+    if (used > a->peak) a->peak = used;
+}
+
+// Drop every allocation. The pages stay mapped and faulted in. Not safe
+// against concurrent arena_alloc().
+static inline void arena_reset(arena_t *a) {
+    arena_update_peak(a);
+    a->offset = 0;
+    a->resets++;
+}
+
+static inline void arena_stats(arena_t *a, arena_stats_t *s) {
+    arena_page_info_t info;
+    arena_update_peak(a);
+    arena_read_page_info(a->base, &info);
+
+    s->capacity = a->capacity;
+    s->used = __atomic_load_n(&a->offset, __ATOMIC_RELAXED);
+    s->peak = a->peak;
+    s->allocs = __atomic_load_n(&a->allocs, __ATOMIC_RELAXED);
+    s->failed_allocs = __atomic_load_n(&a->failed_allocs, __ATOMIC_RELAXED);
+    s->resets = a->resets;
+    s->requested = a->opts.pages;
+    s->mapped = a->mapped;
+    s->obtained = arena_backing_name(&info);
+    s->kernel_page_kb = info.kernel_page_kb;
+    s->anon_huge_kb = info.anon_huge_kb;
+    s->numa_node = a->numa_node;
+    s->prefault_threads = a->prefault_threads;
+    s->prefault_ms = a->prefault_ms;
+}
+
+static inline void arena_print_stats(const arena_stats_t *s) {
+    printf("Arena: %.2f MB, requested %s, mapped %s, obtained %s (KernelPageSize %zu kB, "
+           "AnonHugePages %zu kB)\n",
+           s->capacity / 1048576.0, arena_pages_names[s->requested], arena_pages_names[s->mapped],
+           s->obtained, s->kernel_page_kb, s->anon_huge_kb);
+    printf("  used %.2f MB, peak %.2f MB, %lu allocs, %lu failed, %lu resets",
+           s->used / 1048576.0, s->peak / 1048576.0, s->allocs, s->failed_allocs, s->resets);
+    if (s->numa_node >= 0) printf(", node %d", s->numa_node);
+    if (s->prefault_threads > 0) {
+        printf(", prefault %.2f ms on %d threads", s->prefault_ms, s->prefault_threads);
+    }
+    printf("\n");
+}
+
+static inline void arena_destroy(arena_t *a) {
+    if (!a) return;
+    munmap(a->base, a->capacity);
+    free(a);
+}
+
+#endif
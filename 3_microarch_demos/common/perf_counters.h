@@ -0,0 +1,163 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+// In-process hardware counters around a timed region, so setup work
+// (memset, shuffle, mmap) no longer pollutes the numbers the way a whole-program
+// `perf stat` does.
+//
+// One perf_event_open group (leader: cycles) is opened for the calling thread
+// with inherit=1, so threads created inside the region are counted too once
+// they have been joined. PERF_EVENT_IOC_RESET does not clear what exited
+// children already folded into the parent's counts, so each region reads a
+// baseline at begin and reports the difference at end. Events the CPU or
+// hypervisor does not expose are skipped; if the leader itself cannot be
+// opened the counters stay disabled and regions cost nothing.
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <linux/perf_event.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+typedef enum {
+    PC_CYCLES,
+    PC_INSTRUCTIONS,
+    PC_L1D_MISSES,
+    PC_LLC_MISSES,
+    PC_DTLB_MISSES,
+    PC_NUM_EVENTS,
+} pc_event_t;
+
+static const char *const pc_event_names[PC_NUM_EVENTS] = {
+    "cycles", "instructions", "l1d_misses", "llc_misses", "dtlb_misses",
+};
+
+#define PC_CACHE_READ_MISS(cache) \
+    ((cache) | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16))
+
+static const struct { uint32_t type; uint64_t config; } pc_event_attrs[PC_NUM_EVENTS] = {
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    { PERF_TYPE_HW_CACHE, PC_CACHE_READ_MISS(PERF_COUNT_HW_CACHE_L1D) },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+    { PERF_TYPE_HW_CACHE, PC_CACHE_READ_MISS(PERF_COUNT_HW_CACHE_DTLB) },
+};
+
+// Counter deltas for one region; valid has bit (1 << event) set per counted event
+typedef struct {
+    unsigned valid;
+    double count[PC_NUM_EVENTS];
+} perf_sample_t;
+
+typedef struct {
+    int fd[PC_NUM_EVENTS];      // -1 when the event is unavailable
+    int opened;                 // 1 once open was attempted
+    uint64_t base[PC_NUM_EVENTS][3];    // value, enabled, running at region begin
+} perf_counters_t;
+
+static perf_counters_t pc_state = { .opened = 0 };
+static int pc_enabled;          // Set by --counters
+static perf_sample_t pc_last;   // Deltas of the most recent region
+
+static inline int pc_open_event(pc_event_t e, int group_fd) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = pc_event_attrs[e].type;
+    attr.config = pc_event_attrs[e].config;
+    attr.disabled = group_fd < 0;       // Only the leader starts disabled
+    attr.inherit = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0);
+}
+
+// Open the counter group for the calling thread. Returns the number of events
+// that could be opened (0 when no hardware counters are available).
+static inline int perf_counters_open(perf_counters_t *pc) {
+    int opened = 0;
+    pc->opened = 1;
+    for (int e = 0; e < PC_NUM_EVENTS; e++) pc->fd[e] = -1;
+
+    pc->fd[PC_CYCLES] = pc_open_event(PC_CYCLES, -1);
+    if (pc->fd[PC_CYCLES] < 0) {
+        perror("perf_event_open cycles (hardware counters unavailable)");
+        return 0;
+    }
+    opened++;
+    for (int e = PC_CYCLES + 1; e < PC_NUM_EVENTS; e++) {
+        pc->fd[e] = pc_open_event((pc_event_t)e, pc->fd[PC_CYCLES]);
+        if (pc->fd[e] >= 0) opened++;
+    }
+    return opened;
+}
+
+static inline void perf_counters_close(perf_counters_t *pc) {
+    for (int e = 0; e < PC_NUM_EVENTS; e++) {
+        if (pc->fd[e] >= 0) close(pc->fd[e]);
+        pc->fd[e] = -1;
+    }
+}
+
+// Snapshot every counter as the region baseline, then enable the group
+static inline void perf_counters_start(perf_counters_t *pc) {
+    if (pc->fd[PC_CYCLES] < 0) return;
+    for (int e = 0; e < PC_NUM_EVENTS; e++) {
+        size_t len = sizeof(pc->base[e]);
+        if (pc->fd[e] < 0 || read(pc->fd[e], pc->base[e], len) != (ssize_t)len) {
+            memset(pc->base[e], 0, len);
+        }
+    }
+    ioctl(pc->fd[PC_CYCLES], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+}
+
+// Stop the group and read each counter's delta since perf_counters_start,
+// scaled up if it was multiplexed
+static inline void perf_counters_stop(perf_counters_t *pc, perf_sample_t *out) {
+    memset(out, 0, sizeof(*out));
+    if (pc->fd[PC_CYCLES] < 0) return;
+    ioctl(pc->fd[PC_CYCLES], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+    for (int e = 0; e < PC_NUM_EVENTS; e++) {
+        uint64_t v[3];      // value, time_enabled, time_running
+        if (pc->fd[e] < 0 || read(pc->fd[e], v, sizeof(v)) != sizeof(v)) continue;
+        for (int k = 0; k < 3; k++) v[k] -= pc->base[e][k];
+        if (v[2] == 0) continue;
+        out->count[e] = v[2] < v[1] ? (double)v[0] * v[1] / v[2] : (double)v[0];
+        out->valid |= 1u << e;
+    }
+}
+
+// Region helpers used by the demos' timed sections. No-ops unless --counters
+// was given; the first region opens the group on the calling thread.
+static inline void pc_region_begin(void) {
+    if (!pc_enabled) return;
+    if (!pc_state.opened) perf_counters_open(&pc_state);
+    perf_counters_start(&pc_state);
+}
+
+static inline void pc_region_end(void) {
+    if (!pc_enabled) return;
+    perf_counters_stop(&pc_state, &pc_last);
+}
+
+// Print "cycles=... ipc=..." for a sample; prints nothing if it is empty
+static inline void perf_sample_print(const perf_sample_t *s) {
+    if (!s->valid) return;
+    printf("   counters:");
+    for (int e = 0; e < PC_NUM_EVENTS; e++) {
+        if (s->valid & (1u << e)) printf(" %s=%.0f", pc_event_names[e], s->count[e]);
+    }
+    if ((s->valid & 3u) == 3u && s->count[PC_CYCLES] > 0) {
+        printf(" ipc=%.2f", s->count[PC_INSTRUCTIONS] / s->count[PC_CYCLES]);
+    }
+    printf("\n");
+}
+
+#endif
@@ -0,0 +1,190 @@
+#ifndef PERM_H
+#define PERM_H
+
+// Fast, unbiased random permutations for the microarch demos.
+//
+// Randomness comes from a counter-based generator (SplitMix64 finalizer over
+// key + counter), so every task gets an independent stream and the result
+// depends only on the seed, not on the thread count. Shuffling uses
+// MergeShuffle (Bacher et al. 2015): cache-sized leaf blocks are shuffled with
+// Fisher-Yates in parallel, then merged pairwise level by level. Bounded draws
+// use Lemire's multiply-shift with rejection, so there is no modulo bias.
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#ifndef PERM_LEAF_ELEMS
+#define PERM_LEAF_ELEMS (64 * 1024)   // Leaf block: 512 KiB of size_t, stays in L2
+#endif
+#define PERM_MAX_THREADS 256
+
+typedef struct {
+    uint64_t key;
+    uint64_t ctr;
+    uint64_t bits;      // Buffered random bits for merge coin flips
+    int nbits;
+} perm_rng_t;
+
+static inline uint64_t perm_mix64(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+static inline void perm_rng_init(perm_rng_t *r, uint64_t seed, uint64_t stream) {
+    r->key = perm_mix64(seed ^ perm_mix64(stream + 0x9e3779b97f4a7c15ULL));
+    r->ctr = 0;
+    r->bits = 0;
+    r->nbits = 0;
+}
+
+static inline uint64_t perm_next(perm_rng_t *r) {
+    return perm_mix64(r->key + (r->ctr++) * 0x9e3779b97f4a7c15ULL);
+}
+
+// Uniform integer in [0, bound), bound > 0
+static inline uint64_t perm_below(perm_rng_t *r, uint64_t bound) {
+    __uint128_t m = (__uint128_t)perm_next(r) * bound;
+    uint64_t low = (uint64_t)m;
+    if (low < bound) {
+        uint64_t threshold = -bound % bound;
+        while (low < threshold) {
+            m = (__uint128_t)perm_next(r) * bound;
+            low = (uint64_t)m;
+        }
+    }
+    return (uint64_t)(m >> 64);
+}
+
+static inline int perm_flip(perm_rng_t *r) {
+    if (r->nbits == 0) {
+        r->bits = perm_next(r);
+        r->nbits = 64;
+    }
+    int bit = r->bits & 1;
+    r->bits >>= 1;
+    r->nbits--;
+    return bit;
+}
+
+static inline void perm_swap(size_t *a, size_t i, size_t j) {
+    size_t tmp = a[i];
+    a[i] = a[j];
+    a[j] = tmp;
+}
+
+static inline void perm_fisher_yates(size_t *a, size_t n, perm_rng_t *r) {
+    for (size_t i = n; i > 1; i--) {
+        perm_swap(a, i - 1, perm_below(r, i));
+    }
+}
+
+// MergeShuffle merge step: a[0, mid) and a[mid, n) are each uniformly shuffled;
+// afterwards the whole of a[0, n) is uniformly shuffled
+static inline void perm_merge(size_t *a, size_t mid, size_t n, perm_rng_t *r) {
+    size_t i = 0, j = mid;
+    for (;;) {
+        // While both halves are non-empty no step can terminate the merge, so
+        // consume 64 flips per draw and swap without a 50/50 unpredictable
+        // branch. The a[j] store goes to a scratch slot when no swap happens,
+        // which keeps the next a[j] load off the store-forwarding path.
+        while (i < j && j < n) {
+            size_t steps = j - i < n - j ? j - i : n - j;
+            if (steps > 64) steps = 64;
+            uint64_t bits = perm_next(r);
+            size_t scratch;
+            for (size_t k = 0; k < steps; k++) {
+                size_t bit = (size_t)(bits & 1);
+                bits >>= 1;
+                size_t ai = a[i], aj = a[j];
+                a[i] = bit ? aj : ai;
+                *(bit ? &a[j] : &scratch) = ai;
+                j += bit;
+                i++;
+            }
+        }
+        if (perm_flip(r)) {
+            if (j == n) break;
+            perm_swap(a, i, j);
+            j++;
+        } else if (i == j) {
+            break;
+        }
+        i++;
+    }
+    for (; i < n; i++) {
+        perm_swap(a, i, perm_below(r, i + 1));
+    }
+}
+
+typedef struct {
+    size_t *a;
+    size_t n;
+    uint64_t seed;
+    size_t nleaves;     // Power of two
+    size_t width;       // Leaves per task at this level (1 = leaf shuffle)
+    size_t ntasks;
+    size_t next_task;   // Claimed with an atomic fetch-add
+} perm_job_t;
+
+static inline size_t perm_leaf_start(const perm_job_t *job, size_t leaf) {
+    return (size_t)((__uint128_t)job->n * leaf / job->nleaves);
+}
+
+static inline void *perm_worker(void *arg) {
+    perm_job_t *job = (perm_job_t *)arg;
+    for (;;) {
+        size_t t = __atomic_fetch_add(&job->next_task, 1, __ATOMIC_RELAXED);
+        if (t >= job->ntasks) break;
+
+        size_t lo = perm_leaf_start(job, t * job->width);
+        size_t hi = perm_leaf_start(job, (t + 1) * job->width);
+        perm_rng_t r;
+        perm_rng_init(&r, job->seed, ((uint64_t)job->width << 40) ^ t);
+
+        if (job->width == 1) {
+            perm_fisher_yates(job->a + lo, hi - lo, &r);
+        } else {
+            size_t mid = perm_leaf_start(job, t * job->width + job->width / 2);
+            perm_merge(job->a + lo, mid - lo, hi - lo, &r);
+        }
+    }
+    return NULL;
+}
+
+// Uniformly shuffle a[0, n) in place. nthreads <= 0 means one per online CPU.
+static inline void perm_shuffle(size_t *a, size_t n, uint64_t seed, int nthreads) {
+    if (n < 2) return;
+    if (nthreads <= 0) nthreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (nthreads > PERM_MAX_THREADS) nthreads = PERM_MAX_THREADS;
+
+    perm_job_t job = { .a = a, .n = n, .seed = seed, .nleaves = 1 };
+    while (n / job.nleaves > PERM_LEAF_ELEMS) job.nleaves *= 2;
+
+    for (job.width = 1; job.width <= job.nleaves; job.width *= 2) {
+        job.ntasks = job.nleaves / job.width;
+        job.next_task = 0;
+
+        int workers = job.ntasks < (size_t)nthreads ? (int)job.ntasks : nthreads;
+        pthread_t tids[PERM_MAX_THREADS];
+        int started = 0;
+        for (int i = 1; i < workers; i++) {
+            if (pthread_create(&tids[started], NULL, perm_worker, &job) == 0) started++;
+        }
+        perm_worker(&job);
+        for (int i = 0; i < started; i++) pthread_join(tids[i], NULL);
+    }
+}
+
+// Fill order[0, n) with a uniformly random permutation of 0..n-1
+static inline void perm_random_order(size_t *order, size_t n, uint64_t seed, int nthreads) {
+    for (size_t i = 0; i < n; i++) order[i] = i;
+    perm_shuffle(order, n, seed, nthreads);
+}
+
+#endif
@@ -1,21 +1,349 @@
 #ifndef BIND_THREADS_H
 #define BIND_THREADS_H
 
+// Thread pinning plus CPU topology from /sys/devices/system/{cpu,node}:
+// SMT siblings, physical cores, L2/L3 sharing groups, packages and NUMA
+// nodes of the CPUs this process may run on, and placement policies that
+// map thread index -> CPU so "thread 1" means the same thing on every box.
+//
+//   argc = topo_init_args(argc, argv);          // strips --placement NAME
+//   bind_thread_to_core(topo_cpu_for_thread(t));
+//
+// Placement policies (--placement, default cores):
+//   linear   CPUs in id order, the old "thread t on CPU t" behaviour
+//   cores    one thread per physical core first, SMT siblings only after
+//   pack     fill SMT siblings, then the rest of the L2/L3 group, then the next
+//   spread   round-robin over L3 domains, distinct cores before siblings
+// Thread indices past the CPU count wrap around.
+
+#ifndef _GNU_SOURCE
 #define _GNU_SOURCE
+#endif
+#include <dirent.h>
 #include <pthread.h>
 #include <sched.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 
-static inline void bind_thread_to_core(int core_id) {
+#define TOPO_MAX_CPUS 1024
+#define TOPO_MAX_CACHE_INDEX 16
+#define TOPO_SYSFS_CPU "/sys/devices/system/cpu"
+
+// Returns 0, or -1 after a warning; the caller keeps running unpinned
+static inline int bind_thread_to_core(int core_id) {
     cpu_set_t cpuset;
     CPU_ZERO(&cpuset);
     CPU_SET(core_id, &cpuset);
     int ret = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset);
     if (ret != 0) {
-        perror("pthread_setaffinity_np failed");
-        exit(1);
+        fprintf(stderr, "pthread_setaffinity_np(cpu %d) failed: %s\n", core_id, strerror(ret));
+        return -1;
+    }
+    return 0;
+}
+
+// All group ids are dense (0, 1, 2, ...) in order of their lowest CPU
+typedef struct {
+    int cpu;                // Logical CPU id
+    int core;               // Physical core
+    int smt;                // Thread index within the core
+    int l2;                 // L2 sharing group
+    int l3;                 // L3 sharing group (last-level cache domain)
+    int package;            // Socket
+    int node;               // NUMA node
+} topo_cpu_t;
+
+typedef struct {
+    int ncpus;
+    int ncores, nl2, nl3, npackages, nnodes;
+    topo_cpu_t cpus[TOPO_MAX_CPUS];     // Usable CPUs in id order
+} topo_t;
+
+typedef enum {
+    TOPO_LINEAR,
+    TOPO_CORES,
+    TOPO_PACK,
+    TOPO_SPREAD,
+} topo_policy_t;
+
+static const char *const topo_policy_names[] = { "linear", "cores", "pack", "spread" };
+#define TOPO_NUM_POLICIES 4
+
+// How two CPUs relate, innermost sharing level first
+typedef enum {
+    TOPO_SAME_CPU,
+    TOPO_SMT_SIBLING,       // Same physical core
+    TOPO_SAME_L2,           // Different cores sharing an L2 (e.g. Intel E-core clusters)
+    TOPO_SAME_L3,           // Different L2, same last-level cache
+    TOPO_SAME_NODE,         // Different L3 (CCX/CCD), same NUMA node
+    TOPO_SAME_PACKAGE,      // Different node, same socket (sub-NUMA clustering)
+    TOPO_CROSS_PACKAGE,
+} topo_relation_t;
+
+static const char *const topo_relation_names[] = {
+    "same_cpu", "smt_sibling", "same_l2", "same_l3", "same_node", "same_package", "cross_package",
+};
+
+static topo_t topo_state;
+static topo_policy_t topo_policy = TOPO_CORES;
+static int topo_order[TOPO_MAX_CPUS];      // Placement order of topo_policy, as CPU ids
+static pthread_once_t topo_once = PTHREAD_ONCE_INIT;
+
+static inline int topo_read_int(const char *path, int *v) {
+    FILE *f = fopen(path, "r");
+    if (!f) return -1;
+    int ok = fscanf(f, "%d", v) == 1;
+    fclose(f);
+    return ok ? 0 : -1;
+}
+
+// Lowest CPU in a sysfs cpulist file ("0-3,8-11"), or -1. The lowest member
+// is a stable key for the group the list describes.
+static inline int topo_first_in_list(const char *path) {
+    FILE *f = fopen(path, "r");
+    if (!f) return -1;
+    char buf[4096];
+    int first = -1;
+    if (fgets(buf, sizeof(buf), f)) {
+        for (char *tok = strtok(buf, ",\n"); tok; tok = strtok(NULL, ",\n")) {
+            int lo;
+            if (sscanf(tok, "%d", &lo) == 1 && (first < 0 || lo < first)) first = lo;
+        }
+    }
+    fclose(f);
+    return first;
+}
+
+// Lowest CPU sharing the cache at the given level with cpu, or -1
+static inline int topo_cache_key(int cpu, int level) {
+    char path[256];
+    for (int i = 0; i < TOPO_MAX_CACHE_INDEX; i++) {
+        int lvl;
+        snprintf(path, sizeof(path), TOPO_SYSFS_CPU "/cpu%d/cache/index%d/level", cpu, i);
+        if (topo_read_int(path, &lvl) != 0) break;
+        if (lvl != level) continue;
+        // Skip the instruction side of a split level
+        snprintf(path, sizeof(path), TOPO_SYSFS_CPU "/cpu%d/cache/index%d/type", cpu, i);
+        FILE *f = fopen(path, "r");
+        char type[32] = "";
+        if (f) {
+            if (!fgets(type, sizeof(type), f)) type[0] = 0;
+            fclose(f);
+        }
+        if (strncmp(type, "Instruction", 11) == 0) continue;
+        snprintf(path, sizeof(path), TOPO_SYSFS_CPU "/cpu%d/cache/index%d/shared_cpu_list", cpu, i);
+        return topo_first_in_list(path);
+    }
+    return -1;
+}
+
+// NUMA node from the cpuN/nodeM link, or -1
+static inline int topo_cpu_node(int cpu) {
+    char path[128];
+    snprintf(path, sizeof(path), TOPO_SYSFS_CPU "/cpu%d", cpu);
+    DIR *d = opendir(path);
+    if (!d) return -1;
+    int node = -1;
+    struct dirent *e;
+    while ((e = readdir(d))) {
+        if (strncmp(e->d_name, "node", 4) == 0 && sscanf(e->d_name + 4, "%d", &node) == 1) break;
+    }
+    closedir(d);
+    return node;
+}
+
+// Replace raw keys (any ints) by dense ids in order of first appearance
+static inline int topo_densify(int *keys, int n) {
+    int distinct[TOPO_MAX_CPUS], count = 0;
+    for (int i = 0; i < n; i++) {
+        int id = 0;
+        while (id < count && distinct[id] != keys[i]) id++;
+        if (id == count) distinct[count++] = keys[i];
+        keys[i] = id;
+    }
+    return count;
+}
+
+// Fill t from sysfs for the CPUs in the affinity mask. Anything sysfs does
+// not expose degrades to "every CPU is its own core, one L3, one node".
+static inline void topo_discover(topo_t *t) {
+    int core[TOPO_MAX_CPUS], l2[TOPO_MAX_CPUS], l3[TOPO_MAX_CPUS];
+    int package[TOPO_MAX_CPUS], node[TOPO_MAX_CPUS];
+    char path[256];
+    cpu_set_t set;
+
+    memset(t, 0, sizeof(*t));
+    if (sched_getaffinity(0, sizeof(set), &set) != 0) {
+        CPU_ZERO(&set);
+        CPU_SET(0, &set);
+    }
+    for (int c = 0; c < CPU_SETSIZE && t->ncpus < TOPO_MAX_CPUS; c++) {
+        if (!CPU_ISSET(c, &set)) continue;
+        int i = t->ncpus++;
+        t->cpus[i].cpu = c;
+
+        snprintf(path, sizeof(path), TOPO_SYSFS_CPU "/cpu%d/topology/core_cpus_list", c);
+        core[i] = topo_first_in_list(path);
+        if (core[i] < 0) {
+            snprintf(path, sizeof(path), TOPO_SYSFS_CPU "/cpu%d/topology/thread_siblings_list", c);
+            core[i] = topo_first_in_list(path);
+        }
+        if (core[i] < 0) core[i] = c;
+        l2[i] = topo_cache_key(c, 2);
+        if (l2[i] < 0) l2[i] = core[i];
+        l3[i] = topo_cache_key(c, 3);   // -1 everywhere without an L3: one domain
+        snprintf(path, sizeof(path), TOPO_SYSFS_CPU "/cpu%d/topology/physical_package_id", c);
+        if (topo_read_int(path, &package[i]) != 0 || package[i] < 0) package[i] = 0;
+        node[i] = topo_cpu_node(c);
+        if (node[i] < 0) node[i] = 0;
+    }
+
+    // SMT index: siblings seen before this CPU on the same core
+    for (int i = 0; i < t->ncpus; i++) {
+        for (int j = 0; j < i; j++) t->cpus[i].smt += core[j] == core[i];
+    }
+    t->ncores = topo_densify(core, t->ncpus);
+    t->nl2 = topo_densify(l2, t->ncpus);
+    t->nl3 = topo_densify(l3, t->ncpus);
+    t->npackages = topo_densify(package, t->ncpus);
+    t->nnodes = topo_densify(node, t->ncpus);
+    for (int i = 0; i < t->ncpus; i++) {
+        t->cpus[i].core = core[i];
+        t->cpus[i].l2 = l2[i];
+        t->cpus[i].l3 = l3[i];
+        t->cpus[i].package = package[i];
+        t->cpus[i].node = node[i];
+    }
+}
+
+static inline const topo_cpu_t *topo_lookup(const topo_t *t, int cpu) {
+    for (int i = 0; i < t->ncpus; i++) {
+        if (t->cpus[i].cpu == cpu) return &t->cpus[i];
+    }
+    return NULL;
+}
+
+static inline topo_relation_t topo_relation(const topo_t *t, int cpu_a, int cpu_b) {
+    const topo_cpu_t *a = topo_lookup(t, cpu_a), *b = topo_lookup(t, cpu_b);
+    if (!a || !b) return TOPO_CROSS_PACKAGE;
+    if (a->cpu == b->cpu) return TOPO_SAME_CPU;
+    if (a->core == b->core) return TOPO_SMT_SIBLING;
+    if (a->l2 == b->l2) return TOPO_SAME_L2;
+    if (a->l3 == b->l3) return TOPO_SAME_L3;
+    if (a->node == b->node) return TOPO_SAME_NODE;
+    if (a->package == b->package) return TOPO_SAME_PACKAGE;
+    return TOPO_CROSS_PACKAGE;
+}
+
+// First pair of usable CPUs (lowest ids first) whose relation is rel. Returns
+// 0 and sets *a, *b, or -1 if this machine has no such pair.
+static inline int topo_find_pair(const topo_t *t, topo_relation_t rel, int *a, int *b) {
+    for (int i = 0; i < t->ncpus; i++) {
+        for (int j = i; j < t->ncpus; j++) {
+            if (topo_relation(t, t->cpus[i].cpu, t->cpus[j].cpu) == rel) {
+                *a = t->cpus[i].cpu;
+                *b = t->cpus[j].cpu;
+                return 0;
+            }
+        }
+    }
+    return -1;
+}
+
+typedef struct {
+    uint64_t key;
+    int cpu;
+} topo_sort_t;
+
+static inline int topo_cmp_sort(const void *x, const void *y) {
+    const topo_sort_t *a = (const topo_sort_t *)x, *b = (const topo_sort_t *)y;
+    if (a->key != b->key) return a->key < b->key ? -1 : 1;
+    return a->cpu - b->cpu;
+}
+
+// Pack up to four 16-bit fields into a sort key, most significant first
+static inline uint64_t topo_key(int a, int b, int c, int d) {
+    return ((uint64_t)a << 48) | ((uint64_t)b << 32) | ((uint64_t)c << 16) | (uint64_t)d;
+}
+
+// Write the CPU ids for threads 0 .. n-1 under policy to cpus[]. Threads
+// beyond the usable CPU count wrap around. Returns n.
+static inline int topo_place(const topo_t *t, topo_policy_t policy, int *cpus, int n) {
+    topo_sort_t order[TOPO_MAX_CPUS];
+    int core_rank[TOPO_MAX_CPUS];   // Position of each core within its L3, by core id
+    int next_rank[TOPO_MAX_CPUS] = { 0 };
+
+    for (int c = 0; c < t->ncores; c++) core_rank[c] = -1;
+    for (int i = 0; i < t->ncpus; i++) {
+        const topo_cpu_t *p = &t->cpus[i];
+        if (core_rank[p->core] < 0) core_rank[p->core] = next_rank[p->l3]++;
+    }
+
+    for (int i = 0; i < t->ncpus; i++) {
+        const topo_cpu_t *p = &t->cpus[i];
+        uint64_t key;
+        switch (policy) {
+        case TOPO_CORES: key = topo_key(p->smt, p->node, p->l3, p->core); break;
+        case TOPO_PACK: key = topo_key(p->node, p->l3, p->core, p->smt); break;
+        case TOPO_SPREAD: key = topo_key(p->smt, core_rank[p->core], p->node, p->l3); break;
+        default: key = 0; break;
+        }
+        order[i] = (topo_sort_t){ key, p->cpu };
+    }
+    qsort(order, t->ncpus, sizeof(order[0]), topo_cmp_sort);
+    for (int i = 0; i < n; i++) cpus[i] = order[i % t->ncpus].cpu;
+    return n;
+}
+
+static inline void topo_init_once(void) {
+    topo_discover(&topo_state);
+    topo_place(&topo_state, topo_policy, topo_order,
+               topo_state.ncpus < TOPO_MAX_CPUS ? topo_state.ncpus : TOPO_MAX_CPUS);
+}
+
+// Topology of the usable CPUs, discovered on first use
+static inline const topo_t *topo_get(void) {
+    pthread_once(&topo_once, topo_init_once);
+    return &topo_state;
+}
+
+// CPU for thread index t under the --placement policy
+static inline int topo_cpu_for_thread(int t) {
+    const topo_t *topo = topo_get();
+    return topo_order[t % topo->ncpus];
+}
+
+static inline void topo_print(const topo_t *t) {
+    printf("Topology: %d CPUs, %d cores, %d L2 groups, %d L3 domains, %d packages, %d NUMA nodes; "
+           "placement %s\n", t->ncpus, t->ncores, t->nl2, t->nl3, t->npackages, t->nnodes,
+           topo_policy_names[topo_policy]);
+}
+
+// Strip --placement NAME from argv and discover the topology. Must run
+// before any thread calls topo_cpu_for_thread(). Returns the new argc.
+static inline int topo_init_args(int argc, char *argv[]) {
+    int out = 1;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--placement") == 0 && i + 1 < argc) {
+            const char *name = argv[++i];
+            int found = 0;
+            for (int p = 0; p < TOPO_NUM_POLICIES; p++) {
+                if (strcmp(name, topo_policy_names[p]) == 0) {
+                    topo_policy = (topo_policy_t)p;
+                    found = 1;
+                }
+            }
+            if (!found) fprintf(stderr, "Unknown placement '%s', using %s\n", name,
+                                topo_policy_names[topo_policy]);
+        } else {
+            argv[out++] = argv[i];
+        }
     }
+    argv[out] = NULL;
+    topo_get();
+    return out;
 }
 #endif
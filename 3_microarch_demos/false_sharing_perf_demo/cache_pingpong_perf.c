@@ -4,7 +4,10 @@
 #include <unistd.h>
 #include <time.h>
 #include <sched.h>
+#include <stdatomic.h>
 #include "bind_threads.h"
+#include <string.h>
+#include "../common/bench_stats.h"
 
 #define ITERATIONS 10000000
 #define CACHE_LINE_SIZE 64
@@ -27,6 +30,24 @@ typedef struct {
     volatile int b;
 } padded_t;
 
+// C11 twins of the structs above, same layouts
+typedef struct {
+    atomic_int a;
+    atomic_int b;
+} atomic_false_t;
+
+typedef struct {
+    atomic_int counter;
+    atomic_int ready;
+    atomic_int done;
+} atomic_pingpong_t;
+
+typedef struct {
+    atomic_int a;
+    char padding[CACHE_LINE_SIZE - sizeof(atomic_int)];
+    atomic_int b;
+} atomic_padded_t;
+
 // Lightweight work to emphasize cache effects
 void light_work(volatile int *ptr) {
     (*ptr)++;
@@ -34,7 +55,7 @@ void light_work(volatile int *ptr) {
 
 // False sharing: two threads modify adjacent variables in same cache line
 void *false_sharing_thread1(void *arg) {
-    bind_thread_to_core(0);
+    bind_thread_to_core(topo_cpu_for_thread(0));
     shared_false_t *s = (shared_false_t *)arg;
     // Wait for both threads to be ready
     while (!s->b) sched_yield();
@@ -47,7 +68,7 @@ void *false_sharing_thread1(void *arg) {
 }
 
 void *false_sharing_thread2(void *arg) {
-    bind_thread_to_core(1);
+    bind_thread_to_core(topo_cpu_for_thread(1));
     shared_false_t *s = (shared_false_t *)arg;
     s->b = 1; // Signal ready
     for (int i = 0; i < ITERATIONS; i++) {
@@ -59,7 +80,7 @@ void *false_sharing_thread2(void *arg) {
 
 // True ping-pong: threads alternate modifying the same variable
 void *pingpong_thread1(void *arg) {
-    bind_thread_to_core(0);
+    bind_thread_to_core(topo_cpu_for_thread(0));
     shared_pingpong_t *s = (shared_pingpong_t *)arg;
     
     while (!s->ready) sched_yield(); // Wait for thread2 to be ready
@@ -77,7 +98,7 @@ void *pingpong_thread1(void *arg) {
 }
 
 void *pingpong_thread2(void *arg) {
-    bind_thread_to_core(1);
+    bind_thread_to_core(topo_cpu_for_thread(1));
     shared_pingpong_t *s = (shared_pingpong_t *)arg;
     s->ready = 1; // Signal ready
     
@@ -95,7 +116,7 @@ void *pingpong_thread2(void *arg) {
 
 // Independent access: each thread works on separate cache lines
 void *padded_thread1(void *arg) {
-    bind_thread_to_core(0);
+    bind_thread_to_core(topo_cpu_for_thread(0));
     padded_t *s = (padded_t *)arg;
     // Wait for both threads to be ready
     while (!s->b) sched_yield();
@@ -107,7 +128,7 @@ void *padded_thread1(void *arg) {
 }
 
 void *padded_thread2(void *arg) {
-    bind_thread_to_core(1);
+    bind_thread_to_core(topo_cpu_for_thread(1));
     padded_t *s = (padded_t *)arg;
     s->b = 1; // Signal ready
     for (int i = 0; i < ITERATIONS; i++) {
@@ -117,23 +138,149 @@ void *padded_thread2(void *arg) {
     return NULL;
 }
 
-void run_test(const char *label, void *(*f1)(void *), void *(*f2)(void *), void *shared) {
+// stdatomic.h versions of the three kernels without __sync_synchronize().
+// Every variable has a single writer at a time, so an increment is a load
+// plus a store, not an RMW (lock xadd would be a full barrier on x86 at any
+// order). Only the memory order changes between variants:
+//   seq_cst  seq_cst loads and stores (x86: xchg store; arm64: ldar/stlr)
+//   acq_rel  acquire loads, release stores (x86: plain mov; arm64: ldar/stlr)
+//   relaxed  coherence only, no ordering (plain loads/stores everywhere)
+// The order must be a compile-time constant or GCC silently uses seq_cst,
+// hence one set of functions per order.
+#define ATOMIC_BUMP(p, LD, ST) atomic_store_explicit((p), atomic_load_explicit((p), LD) + 1, ST)
+
+#define DEFINE_ATOMIC_KERNELS(ord, LD, ST)                                                        \
+    static void *atomic_false_thread1_##ord(void *arg) {                                          \
+        bind_thread_to_core(topo_cpu_for_thread(0));                                              \
+        atomic_false_t *s = (atomic_false_t *)arg;                                                \
+        while (!atomic_load_explicit(&s->b, memory_order_acquire)) sched_yield();                 \
+        for (int i = 0; i < ITERATIONS; i++) ATOMIC_BUMP(&s->a, LD, ST);                          \
+        return NULL;                                                                              \
+    }                                                                                             \
+    static void *atomic_false_thread2_##ord(void *arg) {                                          \
+        bind_thread_to_core(topo_cpu_for_thread(1));                                              \
+        atomic_false_t *s = (atomic_false_t *)arg;                                                \
+        atomic_store_explicit(&s->b, 1, memory_order_release);                                    \
+        for (int i = 0; i < ITERATIONS; i++) ATOMIC_BUMP(&s->b, LD, ST);                          \
+        return NULL;                                                                              \
+    }                                                                                             \
+    static void *atomic_pingpong_loop_##ord(atomic_pingpong_t *s, int parity) {                   \
+        for (int i = 0; i < PING_PONG_ROUNDS; i++) {                                              \
+            int c;                                                                                \
+            while ((c = atomic_load_explicit(&s->counter, LD)) % 2 != parity &&                   \
+                   !atomic_load_explicit(&s->done, LD)) {                                         \
+                sched_yield();                                                                    \
+            }                                                                                     \
+            if (atomic_load_explicit(&s->done, LD)) break;                                        \
+            atomic_store_explicit(&s->counter, c + 1, ST);                                        \
+        }                                                                                         \
+        atomic_store_explicit(&s->done, 1, ST);                                                   \
+        return NULL;                                                                              \
+    }                                                                                             \
+    static void *atomic_pingpong_thread1_##ord(void *arg) {                                       \
+        bind_thread_to_core(topo_cpu_for_thread(0));                                              \
+        atomic_pingpong_t *s = (atomic_pingpong_t *)arg;                                          \
+        while (!atomic_load_explicit(&s->ready, memory_order_acquire)) sched_yield();             \
+        return atomic_pingpong_loop_##ord(s, 0);                                                  \
+    }                                                                                             \
+    static void *atomic_pingpong_thread2_##ord(void *arg) {                                       \
+        bind_thread_to_core(topo_cpu_for_thread(1));                                              \
+        atomic_pingpong_t *s = (atomic_pingpong_t *)arg;                                          \
+        atomic_store_explicit(&s->ready, 1, memory_order_release);                                \
+        return atomic_pingpong_loop_##ord(s, 1);                                                  \
+    }                                                                                             \
+    static void *atomic_padded_thread1_##ord(void *arg) {                                         \
+        bind_thread_to_core(topo_cpu_for_thread(0));                                              \
+        atomic_padded_t *s = (atomic_padded_t *)arg;                                              \
+        while (!atomic_load_explicit(&s->b, memory_order_acquire)) sched_yield();                 \
+        for (int i = 0; i < ITERATIONS; i++) ATOMIC_BUMP(&s->a, LD, ST);                          \
+        return NULL;                                                                              \
+    }                                                                                             \
+    static void *atomic_padded_thread2_##ord(void *arg) {                                         \
+        bind_thread_to_core(topo_cpu_for_thread(1));                                              \
+        atomic_padded_t *s = (atomic_padded_t *)arg;                                              \
+        atomic_store_explicit(&s->b, 1, memory_order_release);                                    \
+        for (int i = 0; i < ITERATIONS; i++) ATOMIC_BUMP(&s->b, LD, ST);                          \
+        return NULL;                                                                              \
+    }
+
+DEFINE_ATOMIC_KERNELS(seq_cst, memory_order_seq_cst, memory_order_seq_cst)
+DEFINE_ATOMIC_KERNELS(acq_rel, memory_order_acquire, memory_order_release)
+DEFINE_ATOMIC_KERNELS(relaxed, memory_order_relaxed, memory_order_relaxed)
+
+typedef struct {
+    void *(*f1)(void *);
+    void *(*f2)(void *);
+    void *shared;
+    size_t size;
+} pair_test_t;
+
+// One run of the thread pair; the shared struct is zeroed first so every
+// repetition starts from the same ready/done flags
+static double run_pair_once(void *arg) {
+    pair_test_t *t = (pair_test_t *)arg;
     pthread_t t1, t2;
-    struct timespec start, end;
 
-    clock_gettime(CLOCK_MONOTONIC, &start);
-    pthread_create(&t1, NULL, f1, shared);
-    pthread_create(&t2, NULL, f2, shared);
+    memset(t->shared, 0, t->size);
+    pc_region_begin();
+    double start = bench_now_ns();
+    pthread_create(&t1, NULL, t->f1, t->shared);
+    pthread_create(&t2, NULL, t->f2, t->shared);
     pthread_join(t1, NULL);
     pthread_join(t2, NULL);
-    clock_gettime(CLOCK_MONOTONIC, &end);
+    double elapsed = bench_elapsed_ms(start);
+    pc_region_end();     // Child counts are folded in once both threads exit
+    return elapsed;
+}
+
+double run_test(const char *label, void *(*f1)(void *), void *(*f2)(void *), void *shared,
+                size_t size, double ops) {
+    pair_test_t t = { f1, f2, shared, size };
+    bench_result_t res;
+
+    bench_repeat(run_pair_once, &t, &res);
+    printf("⏱️  %s time: ", label);
+    bench_print_stats(&res);
+    bench_report_stats(label, &res, ops, 0, "threads=2,order=fence");
+    return res.median_ms;
+}
+
+typedef struct {
+    const char *order;
+    void *(*false1)(void *), *(*false2)(void *);
+    void *(*pingpong1)(void *), *(*pingpong2)(void *);
+    void *(*padded1)(void *), *(*padded2)(void *);
+} order_variant_t;
 
-    double elapsed_ms = (end.tv_sec - start.tv_sec) * 1e3 +
-                        (end.tv_nsec - start.tv_nsec) / 1e6;
-    printf("⏱️  %s time: %.2f ms\n", label, elapsed_ms);
+static const order_variant_t atomic_orders[] = {
+    { "seq_cst", atomic_false_thread1_seq_cst, atomic_false_thread2_seq_cst,
+      atomic_pingpong_thread1_seq_cst, atomic_pingpong_thread2_seq_cst,
+      atomic_padded_thread1_seq_cst, atomic_padded_thread2_seq_cst },
+    { "acq_rel", atomic_false_thread1_acq_rel, atomic_false_thread2_acq_rel,
+      atomic_pingpong_thread1_acq_rel, atomic_pingpong_thread2_acq_rel,
+      atomic_padded_thread1_acq_rel, atomic_padded_thread2_acq_rel },
+    { "relaxed", atomic_false_thread1_relaxed, atomic_false_thread2_relaxed,
+      atomic_pingpong_thread1_relaxed, atomic_pingpong_thread2_relaxed,
+      atomic_padded_thread1_relaxed, atomic_padded_thread2_relaxed },
+};
+#define NUM_ATOMIC_ORDERS (int)(sizeof(atomic_orders) / sizeof(atomic_orders[0]))
+
+// Same as run_test but reported only as a table cell
+static double run_ordered(const char *label, const char *order, void *(*f1)(void *),
+                          void *(*f2)(void *), void *shared, size_t size, double ops) {
+    pair_test_t t = { f1, f2, shared, size };
+    bench_result_t res;
+
+    bench_repeat(run_pair_once, &t, &res);
+    bench_report_stats(label, &res, ops, 0, "threads=2,order=%s", order);
+    return res.median_ms;
 }
 
-int main() {
+int main(int argc, char *argv[]) {
+    argc = bench_init(argc, argv, "cache_pingpong_perf");
+    argc = bench_stats_init(argc, argv);
+    topo_init_args(argc, argv);
+
     shared_false_t *fs = aligned_alloc(CACHE_LINE_SIZE, sizeof(shared_false_t));
     shared_pingpong_t *pp = aligned_alloc(CACHE_LINE_SIZE, sizeof(shared_pingpong_t));
     padded_t *pad = aligned_alloc(CACHE_LINE_SIZE, sizeof(padded_t));
@@ -144,14 +291,19 @@ int main() {
     pad->a = pad->b = 0;
 
     printf("=== Enhanced Cache Performance Demo ===\n");
-    printf("Iterations: %d (False Sharing & Padded), %d (Ping-Pong)\n\n", 
+    printf("Iterations: %d (False Sharing & Padded), %d (Ping-Pong)\n", 
            ITERATIONS, PING_PONG_ROUNDS);
+    topo_print(topo_get());
+    printf("Thread pair on CPU %d and %d (%s)\n\n", topo_cpu_for_thread(0), topo_cpu_for_thread(1),
+           topo_relation_names[topo_relation(topo_get(), topo_cpu_for_thread(0), topo_cpu_for_thread(1))]);
     
     // Test 1: False sharing - two threads modify adjacent variables
     printf("📍 False Sharing Test:\n");
     printf("   Two threads modify adjacent int variables in same cache line\n");
     printf("   Expected: High cache miss rate due to false sharing\n");
-    run_test("False Sharing", false_sharing_thread1, false_sharing_thread2, fs);
+    double fence_ms[3];
+    fence_ms[0] = run_test("False Sharing", false_sharing_thread1, false_sharing_thread2, fs, sizeof(*fs),
+             2.0 * ITERATIONS);
     
     // Reset for ping-pong test
     pp->counter = pp->ready = pp->done = 0;
@@ -160,18 +312,53 @@ int main() {
     printf("\n🏓 Cache Ping-Pong Test:\n");
     printf("   Two threads alternate modifying the same variable\n");
     printf("   Expected: Severe cache bouncing between cores\n");
-    run_test("Cache Ping-Pong", pingpong_thread1, pingpong_thread2, pp);
+    fence_ms[1] = run_test("Cache Ping-Pong", pingpong_thread1, pingpong_thread2, pp, sizeof(*pp),
+             2.0 * PING_PONG_ROUNDS);
     
     // Test 3: Padded - separated by cache line boundaries
     printf("\n✅ Cache-Line Padded Test:\n");
     printf("   Two threads modify variables in separate cache lines\n");
     printf("   Expected: Minimal cache interference\n");
-    run_test("Cache-Line Padded", padded_thread1, padded_thread2, pad);
+    fence_ms[2] = run_test("Cache-Line Padded", padded_thread1, padded_thread2, pad, sizeof(*pad),
+             2.0 * ITERATIONS);
+
+    // Test 4: the same kernels on stdatomic.h instead of volatile + full fence
+    static const char *kernels[3] = { "False Sharing", "Cache Ping-Pong", "Cache-Line Padded" };
+    const double kernel_ops[3] = { 2.0 * ITERATIONS, 2.0 * PING_PONG_ROUNDS, 2.0 * ITERATIONS };
+    double ms[NUM_ATOMIC_ORDERS][3];
+    void *buf = aligned_alloc(CACHE_LINE_SIZE, sizeof(atomic_padded_t));
+    printf("\n🧮 Memory Ordering Test:\n");
+    printf("   Same kernels with C11 atomics instead of volatile + __sync_synchronize()\n");
+    for (int o = 0; o < NUM_ATOMIC_ORDERS; o++) {
+        const order_variant_t *v = &atomic_orders[o];
+        ms[o][0] = run_ordered(kernels[0], v->order, v->false1, v->false2, buf, sizeof(atomic_false_t),
+                               kernel_ops[0]);
+        ms[o][1] = run_ordered(kernels[1], v->order, v->pingpong1, v->pingpong2, buf,
+                               sizeof(atomic_pingpong_t), kernel_ops[1]);
+        ms[o][2] = run_ordered(kernels[2], v->order, v->padded1, v->padded2, buf,
+                               sizeof(atomic_padded_t), kernel_ops[2]);
+    }
+    printf("   %-18s %10s", "median ms", "fence");
+    for (int o = 0; o < NUM_ATOMIC_ORDERS; o++) printf(" %10s", atomic_orders[o].order);
+    printf("\n");
+    for (int k = 0; k < 3; k++) {
+        printf("   %-18s %10.2f", kernels[k], fence_ms[k]);
+        for (int o = 0; o < NUM_ATOMIC_ORDERS; o++) printf(" %10.2f", ms[o][k]);
+        printf("\n");
+    }
+    // relaxed is coherence alone; whatever the fence adds on top is ordering
+    int rel = NUM_ATOMIC_ORDERS - 1;
+    printf("   Ordering cost (fence - relaxed): false sharing %.2f ms, padded %.2f ms\n",
+           fence_ms[0] - ms[rel][0], fence_ms[2] - ms[rel][2]);
+    printf("   Coherence cost (false sharing - padded, relaxed): %.2f ms\n", ms[rel][0] - ms[rel][2]);
+    free(buf);
 
     printf("\n📊 Performance Analysis:\n");
     printf("   - False Sharing should be slower than Padded\n");
     printf("   - Ping-Pong should be the slowest due to cache bouncing\n");
     printf("   - Padded should be the fastest with minimal cache conflicts\n");
+    printf("   - relaxed vs fence separates coherence traffic from fence cost;\n"
+           "     acq_rel costs nothing extra on x86, seq_cst pays for its stores\n");
 
     free(fs); free(pp); free(pad);
     return 0;
@@ -0,0 +1,189 @@
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bind_threads.h"
+#include "../common/bench_stats.h"
+#include "../common/perm.h"
+
+#define CACHE_LINE_SIZE 64
+#define DEFAULT_ROUNDS 10000        // Round trips per measured run
+#define DEFAULT_MAX_PAIRS 4096      // Sample beyond this many core pairs
+#define PAIR_SEED 0xC2CULL
+#define TIER_GAP 1.25               // Next latency tier starts 25% above the previous pair
+
+// Core-to-core round trip: the initiator writes an odd sequence number to one
+// cache line and spins until the responder answers with the next even one,
+// so every round moves the line to the other core and back. Measured for
+// every pair of usable CPUs (or a seeded sample of pairs that always keeps
+// the first CPU's row), printed as a CPU x CPU matrix ready for a heatmap.
+// Each pair runs once, with the CPU listed first as initiator. A round trip
+// moves the line both ways, so the matrix is filled symmetrically.
+
+typedef struct {
+    volatile int seq;
+    char pad[CACHE_LINE_SIZE - sizeof(int)];
+} __attribute__((aligned(CACHE_LINE_SIZE))) c2c_line_t;
+
+typedef struct {
+    int cpu_a, cpu_b;
+    long rounds;
+    c2c_line_t *line;
+    pthread_barrier_t barrier;
+    double elapsed_ms;          // Written by the initiator
+} pair_ctx_t;
+
+static void *c2c_initiator(void *arg) {
+    pair_ctx_t *p = (pair_ctx_t *)arg;
+    bind_thread_to_core(p->cpu_a);
+    pthread_barrier_wait(&p->barrier);
+    double start = bench_now_ns();
+    for (int r = 0; r < p->rounds; r++) {
+        __atomic_store_n(&p->line->seq, 2 * r + 1, __ATOMIC_RELEASE);
+        while (__atomic_load_n(&p->line->seq, __ATOMIC_ACQUIRE) != 2 * r + 2) {
+        }
+    }
+    p->elapsed_ms = bench_elapsed_ms(start);
+    return NULL;
+}
+
+static void *c2c_responder(void *arg) {
+    pair_ctx_t *p = (pair_ctx_t *)arg;
+    bind_thread_to_core(p->cpu_b);
+    pthread_barrier_wait(&p->barrier);
+    for (int r = 0; r < p->rounds; r++) {
+        while (__atomic_load_n(&p->line->seq, __ATOMIC_ACQUIRE) != 2 * r + 1) {
+        }
+        __atomic_store_n(&p->line->seq, 2 * r + 2, __ATOMIC_RELEASE);
+    }
+    return NULL;
+}
+
+// One measured run; only the initiator's timed loop counts, not thread setup
+static double run_pair_once(void *arg) {
+    pair_ctx_t *p = (pair_ctx_t *)arg;
+    pthread_t ta, tb;
+
+    p->line->seq = 0;
+    pthread_barrier_init(&p->barrier, NULL, 2);
+    pthread_create(&tb, NULL, c2c_responder, p);
+    pthread_create(&ta, NULL, c2c_initiator, p);
+    pthread_join(ta, NULL);
+    pthread_join(tb, NULL);
+    pthread_barrier_destroy(&p->barrier);
+    return p->elapsed_ms;
+}
+
+int main(int argc, char *argv[]) {
+    argc = bench_init(argc, argv, "core_to_core");
+    argc = bench_stats_init(argc, argv);
+    long rounds = argc >= 2 ? atol(argv[1]) : DEFAULT_ROUNDS;
+    long max_pairs = argc >= 3 ? atol(argv[2]) : DEFAULT_MAX_PAIRS;
+    if (rounds < 1 || max_pairs < 0) {
+        printf("Usage: %s [rounds] [max_pairs (0 = all)] [--format text|json|csv] [--reps N]\n",
+               argv[0]);
+        return 1;
+    }
+
+    const topo_t *topo = topo_get();
+    static int cpus[TOPO_MAX_CPUS];
+    int n = topo->ncpus;
+    for (int i = 0; i < n; i++) cpus[i] = topo->cpus[i].cpu;
+    printf("=== Core-to-Core Cache Line Round Trip ===\n");
+    topo_print(topo);
+    if (n < 2) {
+        printf("Need at least two usable CPUs, have %d\n", n);
+        return 0;
+    }
+
+    // Pair list: the first CPU's row first, then every other pair in a seeded
+    // random order, so a truncated list still anchors the heatmap on one row
+    long total = (long)n * (n - 1) / 2, npairs = 0;
+    int (*pairs)[2] = malloc(total * sizeof(*pairs));
+    double *rtt = malloc((size_t)n * n * sizeof(double));
+    c2c_line_t *line = aligned_alloc(CACHE_LINE_SIZE, sizeof(c2c_line_t));
+    if (!pairs || !rtt || !line) {
+        perror("malloc");
+        return 1;
+    }
+    for (int j = 1; j < n; j++) pairs[npairs][0] = 0, pairs[npairs++][1] = j;
+    for (int i = 1; i < n; i++) {
+        for (int j = i + 1; j < n; j++) pairs[npairs][0] = i, pairs[npairs++][1] = j;
+    }
+    perm_rng_t rng;
+    perm_rng_init(&rng, PAIR_SEED, 0);
+    for (long k = npairs - 1; k > n - 1; k--) {
+        long r = n - 1 + (long)perm_below(&rng, k - (n - 1) + 1);
+        int a = pairs[k][0], b = pairs[k][1];
+        pairs[k][0] = pairs[r][0], pairs[k][1] = pairs[r][1];
+        pairs[r][0] = a, pairs[r][1] = b;
+    }
+    if (max_pairs > 0 && npairs > max_pairs) npairs = max_pairs;
+    for (long k = 0; k < (long)n * n; k++) rtt[k] = -1;
+
+    printf("%d CPUs, %ld of %ld pairs, %ld round trips per run\n\n", n, npairs, total, rounds);
+    for (long k = 0; k < npairs; k++) {
+        int i = pairs[k][0], j = pairs[k][1];
+        pair_ctx_t ctx = { .cpu_a = cpus[i], .cpu_b = cpus[j], .rounds = rounds, .line = line };
+        bench_result_t res;
+        bench_repeat(run_pair_once, &ctx, &res);
+        double ns = res.median_ms * 1e6 / rounds;
+        rtt[i * n + j] = rtt[j * n + i] = ns;
+        bench_report_stats("c2c_rtt", &res, rounds, 0,
+                           "cpu_a=%d,cpu_b=%d,relation=%s,rtt_ns=%.1f,one_way_ns=%.1f", cpus[i], cpus[j],
+                           topo_relation_names[topo_relation(topo, cpus[i], cpus[j])], ns, ns / 2);
+        if (npairs >= 64 && (k + 1) % (npairs / 16) == 0) {
+            fprintf(stderr, "  %ld/%ld pairs\r", k + 1, npairs);
+        }
+    }
+
+    // Heatmap-ready matrix: round-trip ns, "-" for unmeasured cells
+    printf("Round-trip latency (ns), symmetric; each pair measured once, the lower-listed CPU initiating\n");
+    printf("%6s", "cpu");
+    for (int j = 0; j < n; j++) printf(" %6d", cpus[j]);
+    printf("\n");
+    for (int i = 0; i < n; i++) {
+        printf("%6d", cpus[i]);
+        for (int j = 0; j < n; j++) {
+            if (rtt[i * n + j] < 0) printf(" %6s", "-");
+            else printf(" %6.0f", rtt[i * n + j]);
+        }
+        printf("\n");
+    }
+
+    // Latency tiers: measured pairs sorted by round trip, split wherever the
+    // next value jumps by more than TIER_GAP. Usually SMT siblings, same
+    // L3/CCX, other CCX/die and other socket, in that order.
+    double *sorted = malloc(npairs * sizeof(double));
+    if (!sorted) {
+        perror("malloc");
+        return 1;
+    }
+    for (long k = 0; k < npairs; k++) sorted[k] = rtt[pairs[k][0] * n + pairs[k][1]];
+    qsort(sorted, npairs, sizeof(double), bench_cmp_double);
+    printf("\nLatency tiers (round trip):\n");
+    for (long lo = 0, k = 1; k <= npairs; k++) {
+        if (k < npairs && sorted[k] <= sorted[k - 1] * TIER_GAP) continue;
+        printf("  %8.0f - %-8.0f ns  %6ld pairs\n", sorted[lo], sorted[k - 1], k - lo);
+        lo = k;
+    }
+
+    printf("\nNearest partner per CPU:\n");
+    for (int i = 0; i < n; i++) {
+        int best = -1;
+        for (int j = 0; j < n; j++) {
+            double v = rtt[i * n + j];
+            if (v >= 0 && (best < 0 || v < rtt[i * n + best])) best = j;
+        }
+        if (best < 0) continue;
+        printf("  cpu %-4d -> cpu %-4d %8.0f ns  %s\n", cpus[i], cpus[best], rtt[i * n + best],
+               topo_relation_names[topo_relation(topo, cpus[i], cpus[best])]);
+    }
+
+    free(sorted);
+    free(line);
+    free(rtt);
+    free(pairs);
+    return 0;
+}
@@ -0,0 +1,883 @@
+#include <elf.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/perf_event.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include "bind_threads.h"
+
+// perf c2c-style false-sharing detector. Samples memory accesses of a target
+// process with precise load/store events (Intel PEBS mem-loads/mem-stores,
+// AMD IBS op), buckets the sampled data addresses by cache line and reports
+// the lines several threads touch, ranked by HITM (load hit a line modified
+// in another core's cache). Each line is attributed to a symbol, and to a
+// struct field when gdb and debug info are available.
+//
+//   fs_detect [options]                 built-in false-sharing workload
+//   fs_detect [options] -- cmd args...  launch cmd under the detector
+//   fs_detect [options] --pid PID       attach (system-wide events, needs
+//                                       CAP_PERFMON or perf_event_paranoid <= 0)
+//
+// Without precise sampling (VMs, no PMU, ARM SPE which needs AUX decoding)
+// it says why and runs the instrumented demos instead.
+
+#define CACHE_LINE_SIZE 64
+#define LINE_WORDS (CACHE_LINE_SIZE / 8)
+#define DEFAULT_PERIOD 1024         // Sample every Nth qualifying access (IBS needs a multiple of 16)
+#define DEFAULT_LDLAT 30            // Load latency threshold in cycles, as perf c2c
+#define DEFAULT_TOP 10
+#define RING_PAGES 64               // Data pages per ring buffer (power of two)
+#define POLL_MS 100
+#define LINE_TIDS 8                 // Threads tracked per line
+#define LINE_IPS 4                  // Code addresses tracked per line
+#define MAX_EVENTS 4
+#define MAX_FDS (MAX_EVENTS * TOPO_MAX_CPUS)
+#define MAX_MAPS 4096
+#define MAX_OBJECTS 32
+#define SELFTEST_ITERS 200000000L
+
+// ---- Precise event discovery from /sys/bus/event_source ----
+
+typedef enum { ACCESS_LOAD, ACCESS_STORE, ACCESS_ANY } access_kind_t;
+
+typedef struct {
+    const char *pmu;
+    const char *event;          // Name under <pmu>/events, NULL = config 0
+    access_kind_t kind;
+    int system_wide;            // PMU has no per-task context (AMD IBS)
+    unsigned period_align;      // sample_period must be a multiple of this
+} event_candidate_t;
+
+static const event_candidate_t candidates[] = {
+    { "cpu",      "mem-loads",  ACCESS_LOAD,  0, 1 },     // Intel PEBS
+    { "cpu",      "mem-stores", ACCESS_STORE, 0, 1 },
+    { "cpu_core", "mem-loads",  ACCESS_LOAD,  0, 1 },     // Intel hybrid P-cores
+    { "cpu_core", "mem-stores", ACCESS_STORE, 0, 1 },
+    { "ibs_op",   NULL,         ACCESS_ANY,   1, 16 },    // AMD IBS, Linux 6.1+ fills data_src;
+                                                          // EINVAL if period & 0xf
+};
+#define NUM_CANDIDATES (int)(sizeof(candidates) / sizeof(candidates[0]))
+
+typedef struct {
+    char name[64];
+    access_kind_t kind;
+    int system_wide;
+    unsigned period_align;
+    int has_cpus;                   // cpus holds the PMU's CPUs (hybrid parts)
+    cpu_set_t cpus;
+    struct perf_event_attr attr;
+    int has_aux;                    // Needs a mem-loads-aux group leader (Sapphire Rapids+)
+    struct perf_event_attr aux_attr;
+} fs_event_t;
+
+#define SYSFS_PMU "/sys/bus/event_source/devices"
+
+static int read_sysfs_line(const char *path, char *buf, size_t len) {
+    FILE *f = fopen(path, "r");
+    if (!f) return -1;
+    int ok = fgets(buf, (int)len, f) != NULL;
+    fclose(f);
+    if (!ok) return -1;
+    buf[strcspn(buf, "\n")] = 0;
+    return 0;
+}
+
+// Scatter value into attr according to a format spec like "config1:0-15" or
+// "config:0-7,32-35" (low bits of value fill the first range first)
+static int apply_format(struct perf_event_attr *attr, const char *spec, uint64_t value) {
+    __u64 *field;
+    if (strncmp(spec, "config2:", 8) == 0) field = &attr->config2, spec += 8;
+    else if (strncmp(spec, "config1:", 8) == 0) field = &attr->config1, spec += 8;
+    else if (strncmp(spec, "config:", 7) == 0) field = &attr->config, spec += 7;
+    else return -1;
+
+    while (*spec) {
+        int lo, hi, n = 0;
+        if (sscanf(spec, "%d-%d%n", &lo, &hi, &n) != 2) {
+            if (sscanf(spec, "%d%n", &lo, &n) != 1) return -1;
+            hi = lo;
+        }
+        for (int b = lo; b <= hi; b++, value >>= 1) {
+            if (value & 1) *field |= 1ULL << b;
+        }
+        spec += n;
+        if (*spec == ',') spec++;
+    }
+    return 0;
+}
+
+// CPUs a PMU can count on, from "<pmu>/cpus" ("0-15"). Hybrid Intel parts
+// have one core PMU per core type; opening one on another type's CPU gives
+// ENOENT. Returns -1 if the file is absent (the PMU covers every CPU).
+static int load_pmu_cpus(const char *pmu, cpu_set_t *set) {
+    char path[256], buf[1024];
+    snprintf(path, sizeof(path), SYSFS_PMU "/%s/cpus", pmu);
+    if (read_sysfs_line(path, buf, sizeof(buf)) != 0) return -1;
+    CPU_ZERO(set);
+    for (char *save, *range = strtok_r(buf, ",", &save); range; range = strtok_r(NULL, ",", &save)) {
+        int lo, hi;
+        int n = sscanf(range, "%d-%d", &lo, &hi);
+        if (n < 1) continue;
+        if (n == 1) hi = lo;
+        for (int c = lo; c <= hi && c < CPU_SETSIZE; c++) CPU_SET(c, set);
+    }
+    return 0;
+}
+
+// Parse "<pmu>/events/<event>" ("event=0xcd,umask=0x1,ldlat=3") into attr,
+// replacing ldlat with the requested threshold. Returns 0 if the event exists.
+static int load_sysfs_event(const char *pmu, const char *event, int ldlat, struct perf_event_attr *attr) {
+    char path[256], buf[512], spec[128];
+    int type;
+
+    snprintf(path, sizeof(path), SYSFS_PMU "/%s/type", pmu);
+    if (read_sysfs_line(path, buf, sizeof(buf)) != 0 || sscanf(buf, "%d", &type) != 1) return -1;
+    memset(attr, 0, sizeof(*attr));
+    attr->size = sizeof(*attr);
+    attr->type = type;
+    if (!event) return 0;
+
+    snprintf(path, sizeof(path), SYSFS_PMU "/%s/events/%s", pmu, event);
+    if (read_sysfs_line(path, buf, sizeof(buf)) != 0) return -1;
+    for (char *save, *term = strtok_r(buf, ",", &save); term; term = strtok_r(NULL, ",", &save)) {
+        char *eq = strchr(term, '=');
+        uint64_t value = eq ? strtoull(eq + 1, NULL, 0) : 1;
+        if (eq) *eq = 0;
+        if (strcmp(term, "ldlat") == 0) value = ldlat;
+        snprintf(path, sizeof(path), SYSFS_PMU "/%s/format/%s", pmu, term);
+        if (read_sysfs_line(path, spec, sizeof(spec)) != 0 || apply_format(attr, spec, value) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// ---- Sampling: one ring buffer per (event, CPU) ----
+
+typedef struct {
+    int fd;
+    int leader_fd;              // mem-loads-aux leader, or -1
+    void *ring;
+    access_kind_t kind;
+    int filter_pid;             // System-wide event: keep only the target's samples
+} fs_stream_t;
+
+typedef struct {
+    uint64_t ip;
+    uint32_t pid, tid;
+    uint64_t addr;
+    uint32_t cpu, res;
+    uint64_t weight;
+    uint64_t data_src;
+} fs_sample_t;
+
+#define SAMPLE_TYPE (PERF_SAMPLE_IP | PERF_SAMPLE_TID | PERF_SAMPLE_ADDR | PERF_SAMPLE_CPU | \
+                     PERF_SAMPLE_WEIGHT | PERF_SAMPLE_DATA_SRC)
+
+static fs_stream_t streams[MAX_FDS];
+static int nstreams;
+static uint64_t lost_samples;
+
+static long perf_event_open(struct perf_event_attr *attr, pid_t pid, int cpu, int group_fd,
+                            unsigned long flags) {
+    return syscall(SYS_perf_event_open, attr, pid, cpu, group_fd, flags);
+}
+
+static void close_stream(fs_stream_t *st) {
+    munmap(st->ring, (RING_PAGES + 1) * sysconf(_SC_PAGESIZE));
+    close(st->fd);
+    if (st->leader_fd >= 0) close(st->leader_fd);
+}
+
+// Open one CPU's instance of attr, highest precise_ip first, then without
+// the kernel/hypervisor exclusions some PMUs (older IBS) reject. With aux,
+// attr joins a group led by a non-sampling mem-loads-aux event.
+static int open_precise(struct perf_event_attr *attr, const struct perf_event_attr *aux, pid_t pid,
+                        int cpu, int *leader_fd) {
+    *leader_fd = -1;
+    if (aux) {
+        struct perf_event_attr la = *aux;
+        la.disabled = 1;
+        la.exclude_kernel = la.exclude_hv = 1;
+        la.inherit = attr->inherit;
+        *leader_fd = (int)perf_event_open(&la, pid, cpu, -1, PERF_FLAG_FD_CLOEXEC);
+        if (*leader_fd < 0) return -1;
+        attr->disabled = 0;     // Enabled together with the leader
+    }
+    for (int excl = 1; excl >= 0; excl--) {
+        attr->exclude_kernel = attr->exclude_hv = excl;
+        for (int precise = 3; precise >= 1; precise--) {
+            attr->precise_ip = precise;
+            int fd = (int)perf_event_open(attr, pid, cpu, *leader_fd, PERF_FLAG_FD_CLOEXEC);
+            if (fd >= 0) return fd;
+        }
+        if (errno != EINVAL && errno != EOPNOTSUPP) break;
+    }
+    int err = errno;
+    if (*leader_fd >= 0) close(*leader_fd);
+    *leader_fd = -1;
+    errno = err;
+    return -1;
+}
+
+// Open ev on every usable CPU its PMU covers, for pid (or system-wide), and
+// map its ring buffers. A CPU that refuses the event is skipped. Returns the
+// number of CPUs opened, or -1 with errno from the first failure if none.
+static int open_event(fs_event_t *ev, pid_t pid, uint64_t period) {
+    const topo_t *topo = topo_get();
+    size_t page = sysconf(_SC_PAGESIZE), len = (RING_PAGES + 1) * page;
+    struct perf_event_attr attr = ev->attr;
+    attr.sample_period = period;
+    attr.sample_type = SAMPLE_TYPE;
+    attr.disabled = 1;
+    attr.inherit = !ev->system_wide;
+    attr.watermark = 1;
+    attr.wakeup_watermark = RING_PAGES * page / 4;
+
+    int opened = 0, err = 0;
+    for (int i = 0; i < topo->ncpus; i++) {
+        int cpu = topo->cpus[i].cpu, leader_fd;
+        if (ev->has_cpus && !CPU_ISSET(cpu, &ev->cpus)) continue;
+        int fd = open_precise(&attr, ev->has_aux ? &ev->aux_attr : NULL, ev->system_wide ? -1 : pid,
+                              cpu, &leader_fd);
+        if (fd < 0) {
+            if (!err) err = errno;
+            continue;
+        }
+        void *ring = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (ring == MAP_FAILED) {
+            if (!err) err = errno;
+            close(fd);
+            if (leader_fd >= 0) close(leader_fd);
+            continue;
+        }
+        streams[nstreams++] = (fs_stream_t){ fd, leader_fd, ring, ev->kind, ev->system_wide };
+        opened++;
+    }
+    if (opened) return opened;
+    errno = err ? err : ENODEV;     // ENODEV: the PMU covers none of our CPUs
+    return -1;
+}
+
+// ---- Per cache line aggregation ----
+
+typedef struct {
+    uint64_t line;              // Line address; 0 = empty slot
+    uint64_t loads, stores;
+    uint64_t hitm, remote_hitm;
+    uint64_t lat_sum, lat_samples;
+    uint64_t word_loads[LINE_WORDS], word_stores[LINE_WORDS];
+    int ntids, more_tids;
+    uint32_t tids[LINE_TIDS];
+    uint8_t tid_words[LINE_TIDS];   // Bit w: thread touched word w
+    uint64_t ips[LINE_IPS], ip_counts[LINE_IPS];
+} fs_line_t;
+
+static fs_line_t *lines;
+static size_t line_cap, line_count;
+static uint64_t total_samples, matched_samples;
+
+static fs_line_t *line_slot(fs_line_t *table, size_t cap, uint64_t line) {
+    size_t h = (size_t)((line >> 6) * 0x9E3779B97F4A7C15ULL) & (cap - 1);
+    while (table[h].line && table[h].line != line) h = (h + 1) & (cap - 1);
+    return &table[h];
+}
+
+static fs_line_t *line_get(uint64_t line) {
+    if (line_count * 2 >= line_cap) {
+        size_t cap = line_cap ? line_cap * 2 : 4096;
+        fs_line_t *t = calloc(cap, sizeof(fs_line_t));
+        if (!t) {
+            perror("calloc");
+            exit(1);
+        }
+        for (size_t i = 0; i < line_cap; i++) {
+            if (lines[i].line) *line_slot(t, cap, lines[i].line) = lines[i];
+        }
+        free(lines);
+        lines = t;
+        line_cap = cap;
+    }
+    fs_line_t *l = line_slot(lines, line_cap, line);
+    if (!l->line) {
+        l->line = line;
+        line_count++;
+    }
+    return l;
+}
+
+static int is_hitm(union perf_mem_data_src src, int *remote) {
+    int hit_modified = (src.mem_snoop & PERF_MEM_SNOOP_HITM) != 0;
+#ifdef PERF_MEM_SNOOPX_PEER
+    hit_modified |= (src.mem_snoopx & PERF_MEM_SNOOPX_PEER) != 0;     // AMD: from a peer cache
+#endif
+    *remote = src.mem_remote || (src.mem_lvl & (PERF_MEM_LVL_REM_CCE1 | PERF_MEM_LVL_REM_CCE2));
+    return hit_modified;
+}
+
+static void record_sample(const fs_sample_t *s, access_kind_t kind, pid_t target) {
+    total_samples++;
+    if (target > 0 && (pid_t)s->pid != target) return;   // System-wide events see everyone
+    if (s->addr == 0) return;
+    matched_samples++;
+
+    union perf_mem_data_src src = { .val = s->data_src };
+    int store = kind == ACCESS_STORE || (kind == ACCESS_ANY && (src.mem_op & PERF_MEM_OP_STORE));
+    fs_line_t *l = line_get(s->addr & ~(uint64_t)(CACHE_LINE_SIZE - 1));
+    int word = (int)((s->addr & (CACHE_LINE_SIZE - 1)) / 8);
+
+    if (store) {
+        l->stores++;
+        l->word_stores[word]++;
+    } else {
+        int remote;
+        l->loads++;
+        l->word_loads[word]++;
+        if (is_hitm(src, &remote)) {
+            l->hitm++;
+            l->remote_hitm += remote;
+        }
+        if (s->weight) {
+            l->lat_sum += s->weight;
+            l->lat_samples++;
+        }
+    }
+
+    int t = 0;
+    while (t < l->ntids && l->tids[t] != s->tid) t++;
+    if (t == l->ntids) {
+        if (l->ntids < LINE_TIDS) l->tids[l->ntids++] = s->tid;
+        else l->more_tids = 1;
+    }
+    if (t < l->ntids) l->tid_words[t] |= 1u << word;
+
+    int i = 0;
+    while (i < LINE_IPS && l->ip_counts[i] && l->ips[i] != s->ip) i++;
+    if (i < LINE_IPS) {
+        l->ips[i] = s->ip;
+        l->ip_counts[i]++;
+    }
+}
+
+// Consume every complete record in one ring buffer
+static void drain_stream(fs_stream_t *st, pid_t target) {
+    if (!st->filter_pid) target = 0;
+    struct perf_event_mmap_page *meta = st->ring;
+    size_t page = sysconf(_SC_PAGESIZE), size = RING_PAGES * page;
+    char *data = (char *)st->ring + page;
+    uint64_t head = __atomic_load_n(&meta->data_head, __ATOMIC_ACQUIRE);
+    uint64_t tail = meta->data_tail;
+    char buf[512];
+
+    while (tail < head) {
+        struct perf_event_header hdr;
+        for (size_t i = 0; i < sizeof(hdr); i++) ((char *)&hdr)[i] = data[(tail + i) % size];
+        if (hdr.size == 0 || tail + hdr.size > head) break;
+        // Records can wrap around the end of the buffer: copy out first
+        size_t n = hdr.size < sizeof(buf) ? hdr.size : sizeof(buf);
+        for (size_t i = 0; i < n; i++) buf[i] = data[(tail + i) % size];
+
+        if (hdr.type == PERF_RECORD_SAMPLE && n >= sizeof(hdr) + sizeof(fs_sample_t)) {
+            fs_sample_t s;
+            memcpy(&s, buf + sizeof(hdr), sizeof(s));
+            record_sample(&s, st->kind, target);
+        } else if (hdr.type == PERF_RECORD_LOST && n >= sizeof(hdr) + 16) {
+            uint64_t lost;
+            memcpy(&lost, buf + sizeof(hdr) + 8, sizeof(lost));
+            lost_samples += lost;
+        }
+        tail += hdr.size;
+    }
+    __atomic_store_n(&meta->data_tail, tail, __ATOMIC_RELEASE);
+}
+
+// ---- Symbols: /proc/PID/maps plus ELF symbol tables, fields via gdb ----
+
+typedef struct {
+    uint64_t start, end, offset;
+    char path[256];
+} fs_map_t;
+
+static fs_map_t maps[MAX_MAPS];
+static int nmaps;
+
+static void snapshot_maps(pid_t pid) {
+    char path[64], line[512];
+    snprintf(path, sizeof(path), "/proc/%d/maps", (int)pid);
+    FILE *f = fopen(path, "r");
+    if (!f) return;                 // Target gone: keep the last snapshot
+    int n = 0;
+    while (n < MAX_MAPS && fgets(line, sizeof(line), f)) {
+        fs_map_t *m = &maps[n];
+        int pos = 0;
+        m->path[0] = 0;
+        if (sscanf(line, "%lx-%lx %*s %lx %*s %*s %n", &m->start, &m->end, &m->offset, &pos) < 3) continue;
+        if (pos > 0) sscanf(line + pos, "%255[^\n]", m->path);
+        n++;
+    }
+    fclose(f);
+    if (n > 0) nmaps = n;           // A zombie's maps file reads empty
+}
+
+typedef struct {
+    char path[256];
+    char *image;
+    size_t size;
+    const Elf64_Ehdr *eh;
+} fs_object_t;
+
+static fs_object_t objects[MAX_OBJECTS];
+static int nobjects;
+
+static const fs_object_t *object_open(const char *path) {
+    for (int i = 0; i < nobjects; i++) {
+        if (strcmp(objects[i].path, path) == 0) return objects[i].image ? &objects[i] : NULL;
+    }
+    if (nobjects == MAX_OBJECTS) return NULL;
+    fs_object_t *o = &objects[nobjects++];
+    snprintf(o->path, sizeof(o->path), "%s", path);
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    struct stat sb;
+    if (fd < 0) return NULL;
+    if (fstat(fd, &sb) == 0 && sb.st_size >= (off_t)sizeof(Elf64_Ehdr)) {
+        void *p = mmap(NULL, sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p != MAP_FAILED && memcmp(p, ELFMAG, SELFMAG) == 0 &&
+            ((unsigned char *)p)[EI_CLASS] == ELFCLASS64) {
+            o->image = p;
+            o->size = sb.st_size;
+            o->eh = p;
+        } else if (p != MAP_FAILED) {
+            munmap(p, sb.st_size);
+        }
+    }
+    close(fd);
+    return o->image ? o : NULL;
+}
+
+// Link-time address of file offset off, via the PT_LOAD covering it (or the
+// last one, whose bss extends past the file image)
+static uint64_t object_vaddr(const fs_object_t *o, uint64_t off) {
+    const Elf64_Phdr *ph = (const Elf64_Phdr *)(o->image + o->eh->e_phoff);
+    const Elf64_Phdr *best = NULL;
+    for (int i = 0; i < o->eh->e_phnum; i++) {
+        if (ph[i].p_type != PT_LOAD) continue;
+        if (ph[i].p_offset <= off) best = &ph[i];
+    }
+    return best ? best->p_vaddr + (off - best->p_offset) : off;
+}
+
+// Symbol containing vaddr: name, size and offset into it. Returns 0 if found.
+static int object_symbol(const fs_object_t *o, uint64_t vaddr, int want_func, const char **name,
+                         uint64_t *sym_off, uint64_t *sym_size) {
+    const Elf64_Shdr *sh = (const Elf64_Shdr *)(o->image + o->eh->e_shoff);
+    if (o->eh->e_shoff == 0 || o->eh->e_shoff + o->eh->e_shnum * sizeof(*sh) > o->size) return -1;
+    for (int pass = 0; pass < 2; pass++) {
+        unsigned want = pass == 0 ? SHT_SYMTAB : SHT_DYNSYM;
+        for (int i = 0; i < o->eh->e_shnum; i++) {
+            if (sh[i].sh_type != want || sh[i].sh_link >= o->eh->e_shnum) continue;
+            const Elf64_Sym *sym = (const Elf64_Sym *)(o->image + sh[i].sh_offset);
+            const char *strtab = o->image + sh[sh[i].sh_link].sh_offset;
+            size_t n = sh[i].sh_size / sizeof(*sym);
+            for (size_t k = 0; k < n; k++) {
+                int type = ELF64_ST_TYPE(sym[k].st_info);
+                if (type != (want_func ? STT_FUNC : STT_OBJECT)) continue;
+                if (vaddr < sym[k].st_value || vaddr >= sym[k].st_value + sym[k].st_size) continue;
+                *name = strtab + sym[k].st_name;
+                *sym_off = vaddr - sym[k].st_value;
+                *sym_size = sym[k].st_size;
+                return 0;
+            }
+        }
+    }
+    return -1;
+}
+
+// Field of symbol sym (in object path) covering byte offset off, from gdb's
+// "ptype/o" layout. Arrays of structs are reduced to one element first.
+static int gdb_field(const char *path, const char *sym, uint64_t off, uint64_t sym_size,
+                     char *field, size_t len) {
+    static int have_gdb = -1;
+    if (have_gdb < 0) have_gdb = system("command -v gdb >/dev/null 2>&1") == 0;
+    if (!have_gdb || strchr(sym, '\'') || strchr(path, '\'')) return -1;
+
+    char cmd[768], line[512];
+    snprintf(cmd, sizeof(cmd), "gdb -batch -nx -ex 'ptype/o %s' '%s' 2>/dev/null", sym, path);
+    FILE *f = popen(cmd, "r");
+    if (!f) return -1;
+
+    struct { uint64_t off, size; char decl[128]; } fields[256];
+    int nfields = 0;
+    unsigned long elems = 0;
+    while (fgets(line, sizeof(line), f)) {
+        char *p = strstr(line, "/*");
+        char *close = p ? strstr(p, "*/") : NULL;
+        char *bracket = strrchr(line, '[');
+        if (!p || !close) {
+            // Closing "} [N]" of an array variable
+            if (strchr(line, '}') && bracket) elems = strtoul(bracket + 1, NULL, 0);
+            continue;
+        }
+        char *end;
+        uint64_t foff = strtoull(p + 2, &end, 0);
+        if (end == p + 2) continue;     // Header or "total size" comment
+        if (*end == ':') strtoull(end + 1, &end, 0);
+        char *bar = strchr(end, '|');
+        if (!bar || bar > close || nfields == 256) continue;
+        uint64_t fsize = strtoull(bar + 1, NULL, 0);
+        char *decl = close + 2;
+        decl += strspn(decl, " \t");
+        decl[strcspn(decl, ";\n")] = 0;
+        fields[nfields].off = foff;
+        fields[nfields].size = fsize;
+        snprintf(fields[nfields].decl, sizeof(fields[0].decl), "%s", decl);
+        nfields++;
+    }
+    pclose(f);
+    if (nfields == 0) return -1;
+
+    uint64_t elem = elems ? sym_size / elems : 0;
+    uint64_t rel = elem ? off % elem : off;
+    int best = -1;
+    for (int i = 0; i < nfields; i++) {
+        if (rel < fields[i].off || rel >= fields[i].off + fields[i].size) continue;
+        if (best < 0 || fields[i].size <= fields[best].size) best = i;     // Innermost
+    }
+    if (best < 0) return -1;
+    if (elem) snprintf(field, len, "[%lu] %s", (unsigned long)(off / elem), fields[best].decl);
+    else snprintf(field, len, "%s", fields[best].decl);
+    return 0;
+}
+
+// Describe addr as "sym+off (field)" or "[heap]+off" etc.
+static void describe_addr(uint64_t addr, int is_code, char *out, size_t len) {
+    int m = 0;
+    while (m < nmaps && !(addr >= maps[m].start && addr < maps[m].end)) m++;
+    if (m == nmaps) {
+        snprintf(out, len, "%#lx (unmapped at last maps snapshot)", (unsigned long)addr);
+        return;
+    }
+
+    // Anonymous mapping right after a file mapping: that object's bss
+    const fs_map_t *fm = &maps[m];
+    if (fm->path[0] == 0 && m > 0 && maps[m - 1].end == fm->start && maps[m - 1].path[0] == '/') {
+        fm = &maps[m - 1];
+    }
+    const fs_object_t *o = fm->path[0] == '/' ? object_open(fm->path) : NULL;
+    if (o) {
+        uint64_t vaddr = object_vaddr(o, addr - fm->start + fm->offset);
+        const char *sym;
+        uint64_t off, size;
+        const char *base = strrchr(fm->path, '/') + 1;
+        if (object_symbol(o, vaddr, is_code, &sym, &off, &size) == 0) {
+            char field[160];
+            if (!is_code && gdb_field(fm->path, sym, off, size, field, sizeof(field)) == 0) {
+                snprintf(out, len, "%s+%#lx (%s) in %s", sym, (unsigned long)off, field, base);
+            } else {
+                snprintf(out, len, "%s+%#lx in %s", sym, (unsigned long)off, base);
+            }
+            return;
+        }
+        snprintf(out, len, "%s+%#lx", base, (unsigned long)vaddr);
+        return;
+    }
+    snprintf(out, len, "%s+%#lx", maps[m].path[0] ? maps[m].path : "[anon]",
+             (unsigned long)(addr - maps[m].start));
+}
+
+// ---- Report ----
+
+static int line_score_cmp(const void *a, const void *b) {
+    const fs_line_t *x = *(const fs_line_t *const *)a, *y = *(const fs_line_t *const *)b;
+    if (x->hitm != y->hitm) return x->hitm < y->hitm ? 1 : -1;
+    uint64_t sx = x->loads + x->stores, sy = y->loads + y->stores;
+    return (sx < sy) - (sx > sy);
+}
+
+// "false" if two threads touched disjoint words, "true" if every pair overlaps
+static const char *sharing_kind(const fs_line_t *l) {
+    for (int i = 0; i < l->ntids; i++) {
+        for (int j = i + 1; j < l->ntids; j++) {
+            if (!(l->tid_words[i] & l->tid_words[j])) return "FALSE SHARING";
+        }
+    }
+    return "true sharing";
+}
+
+static void print_report(int top) {
+    fs_line_t **ranked = malloc((line_count + 1) * sizeof(*ranked));
+    size_t n = 0;
+    if (!ranked) return;
+    for (size_t i = 0; i < line_cap; i++) {
+        if (lines[i].line && lines[i].ntids >= 2) ranked[n++] = &lines[i];
+    }
+    qsort(ranked, n, sizeof(*ranked), line_score_cmp);
+
+    printf("\n%lu samples, %lu for the target, %lu lost; %zu lines sampled, %zu touched by 2+ threads\n",
+           (unsigned long)total_samples, (unsigned long)matched_samples, (unsigned long)lost_samples,
+           line_count, n);
+    if (n == 0) {
+        printf("No line was sampled from more than one thread. Lower --period or run longer.\n");
+    }
+
+    for (size_t r = 0; r < n && (int)r < top; r++) {
+        const fs_line_t *l = ranked[r];
+        char where[512];
+        describe_addr(l->line, 0, where, sizeof(where));
+        printf("\n#%zu  line %#lx  %s\n", r + 1, (unsigned long)l->line, where);
+        printf("    %s: %lu HITM (%lu remote), %lu loads, %lu stores, %d%s threads",
+               sharing_kind(l), (unsigned long)l->hitm, (unsigned long)l->remote_hitm,
+               (unsigned long)l->loads, (unsigned long)l->stores, l->ntids, l->more_tids ? "+" : "");
+        if (l->lat_samples) printf(", avg load latency %.0f cycles", (double)l->lat_sum / l->lat_samples);
+        printf("\n");
+
+        for (int w = 0; w < LINE_WORDS; w++) {
+            if (!l->word_loads[w] && !l->word_stores[w]) continue;
+            describe_addr(l->line + w * 8, 0, where, sizeof(where));
+            printf("      +0x%02x  %6lu ld %6lu st  tids", w * 8, (unsigned long)l->word_loads[w],
+                   (unsigned long)l->word_stores[w]);
+            for (int t = 0; t < l->ntids; t++) {
+                if (l->tid_words[t] & (1u << w)) printf(" %u", l->tids[t]);
+            }
+            printf("  %s\n", where);
+        }
+        for (int i = 0; i < LINE_IPS && l->ip_counts[i]; i++) {
+            describe_addr(l->ips[i], 1, where, sizeof(where));
+            printf("      code %#lx  %6lu samples  %s\n", (unsigned long)l->ips[i],
+                   (unsigned long)l->ip_counts[i], where);
+        }
+    }
+    free(ranked);
+}
+
+// ---- Targets ----
+
+// Built-in workload: two threads bump neighbouring fields of one struct, two
+// more bump fields padded onto separate lines
+static struct {
+    volatile long reader_hits;
+    volatile long writer_hits;
+} hot_pair __attribute__((aligned(CACHE_LINE_SIZE)));
+
+static struct {
+    volatile long reader_hits __attribute__((aligned(CACHE_LINE_SIZE)));
+    volatile long writer_hits __attribute__((aligned(CACHE_LINE_SIZE)));
+} padded_pair;
+
+static void *selftest_thread(void *arg) {
+    volatile long *v = (volatile long *)arg;
+    for (long i = 0; i < SELFTEST_ITERS / 4; i++) (*v)++;
+    return NULL;
+}
+
+static void selftest_workload(void) {
+    volatile long *targets[] = { &hot_pair.reader_hits, &hot_pair.writer_hits,
+                                 &padded_pair.reader_hits, &padded_pair.writer_hits };
+    pthread_t tids[4];
+    for (int i = 0; i < 4; i++) pthread_create(&tids[i], NULL, selftest_thread, (void *)targets[i]);
+    for (int i = 0; i < 4; i++) pthread_join(tids[i], NULL);
+}
+
+// Fork the target, blocked on a pipe until the events are enabled
+static pid_t spawn_target(char **cmd, int *go_fd) {
+    int p[2];
+    if (pipe(p) != 0) return -1;
+    pid_t pid = fork();
+    if (pid < 0) return -1;
+    if (pid == 0) {
+        char c;
+        close(p[1]);
+        if (read(p[0], &c, 1) != 1) _exit(1);
+        close(p[0]);
+        if (!cmd) {
+            selftest_workload();
+            _exit(0);
+        }
+        execvp(cmd[0], cmd);
+        perror(cmd[0]);
+        _exit(127);
+    }
+    close(p[0]);
+    *go_fd = p[1];
+    return pid;
+}
+
+// No precise sampling: explain, then run the instrumented demos from this directory
+static int run_fallback(const char *reason) {
+    char self[512];
+    printf("Precise memory sampling unavailable: %s\n", reason);
+    printf("Falling back to the instrumented false-sharing demos.\n\n");
+    ssize_t n = readlink("/proc/self/exe", self, sizeof(self) - 1);
+    if (n <= 0) return 1;
+    self[n] = 0;
+    *strrchr(self, '/') = 0;
+    static const char *const demos[] = { "extreme_test", "cache_test" };
+    int ran = 0;
+    for (int i = 0; i < 2; i++) {
+        char path[600];
+        snprintf(path, sizeof(path), "%s/%s", self, demos[i]);
+        if (access(path, X_OK) != 0) continue;
+        printf("--- %s ---\n", demos[i]);
+        fflush(stdout);
+        if (system(path) != 0) printf("%s failed\n", demos[i]);
+        ran = 1;
+    }
+    if (!ran) printf("Build them first: ./run_all_tests.sh (extreme_test, cache_test)\n");
+    return 1;
+}
+
+static volatile sig_atomic_t stop_requested;
+static void on_signal(int sig) { (void)sig; stop_requested = 1; }
+
+int main(int argc, char *argv[]) {
+    argc = topo_init_args(argc, argv);
+    uint64_t period = DEFAULT_PERIOD;
+    int ldlat = DEFAULT_LDLAT, top = DEFAULT_TOP;
+    double duration = 0;
+    pid_t attach = 0;
+    char **cmd = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--") == 0 && i + 1 < argc) {
+            cmd = &argv[i + 1];
+            break;
+        } else if (strcmp(argv[i], "--period") == 0 && i + 1 < argc) {
+            period = strtoull(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--ldlat") == 0 && i + 1 < argc) {
+            ldlat = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--top") == 0 && i + 1 < argc) {
+            top = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--duration") == 0 && i + 1 < argc) {
+            duration = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--pid") == 0 && i + 1 < argc) {
+            attach = atoi(argv[++i]);
+        } else {
+            printf("Usage: %s [--period N] [--ldlat CYCLES] [--top N] [--duration S]\n"
+                   "        [--pid PID | -- cmd args...]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (period == 0 || top < 1) {
+        printf("--period and --top must be positive\n");
+        return 1;
+    }
+
+    printf("=== False Sharing Detector ===\n");
+    topo_print(topo_get());
+
+    // Candidate events present on this machine
+    fs_event_t events[MAX_EVENTS];
+    int nevents = 0;
+    for (int i = 0; i < NUM_CANDIDATES && nevents < MAX_EVENTS; i++) {
+        fs_event_t *ev = &events[nevents];
+        if (load_sysfs_event(candidates[i].pmu, candidates[i].event, ldlat, &ev->attr) != 0) continue;
+        snprintf(ev->name, sizeof(ev->name), "%s/%s", candidates[i].pmu,
+                 candidates[i].event ? candidates[i].event : "");
+        ev->kind = candidates[i].kind;
+        ev->system_wide = candidates[i].system_wide || attach > 0;
+        ev->period_align = candidates[i].period_align;
+        ev->has_cpus = load_pmu_cpus(candidates[i].pmu, &ev->cpus) == 0;
+        ev->has_aux = ev->kind == ACCESS_LOAD &&
+                      load_sysfs_event(candidates[i].pmu, "mem-loads-aux", ldlat, &ev->aux_attr) == 0;
+        nevents++;
+        if (ev->kind == ACCESS_ANY) break;
+    }
+    if (nevents == 0) {
+        return run_fallback(access(SYSFS_PMU "/arm_spe_0", F_OK) == 0
+                                ? "ARM SPE found, but its AUX trace is not decoded here; use perf c2c"
+                                : "no mem-loads/mem-stores (Intel PEBS) or ibs_op (AMD) PMU event");
+    }
+
+    int go_fd = -1;
+    pid_t target = attach;
+    if (!attach) {
+        target = spawn_target(cmd, &go_fd);
+        if (target < 0) {
+            perror("fork");
+            return 1;
+        }
+    }
+
+    int opened = 0;
+    char why[256] = "";
+    for (int i = 0; i < nevents; i++) {
+        uint64_t align = events[i].period_align;
+        uint64_t ev_period = (period + align - 1) / align * align;
+        if (ev_period != period) {
+            printf("%s needs a period that is a multiple of %lu; using %lu\n", events[i].name,
+                   (unsigned long)align, (unsigned long)ev_period);
+        }
+        int ncpus = open_event(&events[i], target, ev_period);
+        if (ncpus > 0) {
+            printf("Sampling %s every %lu accesses on %d CPUs%s\n", events[i].name,
+                   (unsigned long)ev_period, ncpus,
+                   events[i].system_wide ? " (system-wide, filtered by pid)" : "");
+            opened++;
+        } else if (!why[0]) {
+            snprintf(why, sizeof(why), "perf_event_open(%.64s): %.100s%s", events[i].name, strerror(errno),
+                     errno == EACCES || errno == EPERM ? " (check perf_event_paranoid)" : "");
+        }
+    }
+    if (!opened) {
+        if (go_fd >= 0) {
+            kill(target, SIGKILL);
+            waitpid(target, NULL, 0);
+        }
+        return run_fallback(why);
+    }
+
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+    for (int i = 0; i < nstreams; i++) {
+        int fd = streams[i].leader_fd >= 0 ? streams[i].leader_fd : streams[i].fd;
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+    snapshot_maps(target);
+    if (go_fd >= 0) {
+        if (write(go_fd, "g", 1) != 1) perror("write");
+        close(go_fd);
+    }
+    printf("Target pid %d%s\n", (int)target, duration > 0 ? "" : ", until it exits (Ctrl-C to stop)");
+
+    struct pollfd pfds[MAX_FDS];
+    for (int i = 0; i < nstreams; i++) pfds[i] = (struct pollfd){ streams[i].fd, POLLIN, 0 };
+    struct timespec start, now;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int running = 1;
+    while (running && !stop_requested) {
+        poll(pfds, nstreams, POLL_MS);
+        for (int i = 0; i < nstreams; i++) drain_stream(&streams[i], target);
+        snapshot_maps(target);
+
+        if (attach) running = kill(target, 0) == 0;
+        else running = waitpid(target, NULL, WNOHANG) == 0;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        double elapsed = (now.tv_sec - start.tv_sec) + (now.tv_nsec - start.tv_nsec) / 1e9;
+        if (duration > 0 && elapsed >= duration) break;
+    }
+    for (int i = 0; i < nstreams; i++) {
+        int fd = streams[i].leader_fd >= 0 ? streams[i].leader_fd : streams[i].fd;
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+        drain_stream(&streams[i], target);
+        close_stream(&streams[i]);
+    }
+    if (!attach && running) {
+        kill(target, SIGTERM);
+        waitpid(target, NULL, 0);
+    }
+
+    print_report(top);
+    free(lines);
+    return 0;
+}
@@ -0,0 +1,237 @@
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bind_threads.h"
+#include "../common/bench_stats.h"
+#include "mpmc_queues.h"
+
+#define MAX_THREADS 256
+#define QUEUE_CAPACITY 4096
+#define DEFAULT_MESSAGES 1000000    // Total per throughput run, split across producers
+#define LATENCY_MESSAGES 100000     // Total per paced run
+#define DEFAULT_RATE_MMSGS 1.0      // Offered load of the paced run, all producers together
+
+// P producers push cycle-counter stamps into one queue, C consumers pop them,
+// for P and C each in 1, 2, 4, ... max. Producers are threads 0..P-1 and
+// consumers P..P+C-1 of the placement policy.
+//   throughput  every producer sends messages / P stamps back to back
+//   latency     producers together offer rate Mmsg/s; each stamp is the
+//               scheduled send time, so time spent blocked on a full queue
+//               counts (no coordinated omission); consumers record
+//               now - stamp, the enqueue-to-dequeue latency
+// Producer and consumer stamp sums must match or messages were lost or
+// duplicated.
+
+typedef struct {
+    const mpmc_ops_t *ops;
+    void *q;
+    int nprod, ncons;
+    long per_producer;
+    uint64_t gap_ticks;         // Per producer; 0 = unpaced
+    int producers_done __attribute__((aligned(64)));
+    pthread_barrier_t barrier;
+} run_ctx_t;
+
+typedef struct {
+    run_ctx_t *ctx;
+    int index;                  // Producer or consumer number
+    int producer;
+    long count;
+    uint64_t sum;
+    uint32_t *lat;              // Consumer latency ring, in cycle-counter ticks
+    bench_span_t span;
+} __attribute__((aligned(64))) worker_t;
+
+static void producer_loop(worker_t *w) {
+    run_ctx_t *ctx = w->ctx;
+    uint64_t sum = 0, next = bench_cycle_counter();
+    for (long i = 0; i < ctx->per_producer; i++) {
+        uint64_t v;
+        if (ctx->gap_ticks) {
+            while (bench_cycle_counter() < next) {
+            }
+            v = next;
+            next += ctx->gap_ticks;
+        } else {
+            v = bench_cycle_counter();
+        }
+        long spins = 0;
+        while (!ctx->ops->try_push(ctx->q, w->index, v)) bench_spin_pause(&spins);
+        sum += v;
+    }
+    w->count = ctx->per_producer;
+    w->sum = sum;
+    // The last producer out wakes consumers blocked in pop
+    if (__atomic_add_fetch(&ctx->producers_done, 1, __ATOMIC_ACQ_REL) == ctx->nprod) ctx->ops->close(ctx->q);
+}
+
+static void consumer_loop(worker_t *w) {
+    run_ctx_t *ctx = w->ctx;
+    uint64_t sum = 0, v;
+    long count = 0, spins = 0;
+    for (;;) {
+        if (!ctx->ops->try_pop(ctx->q, w->index, &v)) {
+            // Every push happens before producers_done, so one more failed
+            // pop after seeing all producers finish means the queue is drained
+            if (__atomic_load_n(&ctx->producers_done, __ATOMIC_ACQUIRE) < ctx->nprod) {
+                bench_spin_pause(&spins);
+                continue;
+            }
+            if (!ctx->ops->try_pop(ctx->q, w->index, &v)) break;
+        }
+        if (ctx->gap_ticks) {
+            uint64_t dt = bench_cycle_counter() - v;
+            bench_lat_record(w->lat, count, dt);
+        }
+        sum += v;
+        count++;
+    }
+    w->count = count;
+    w->sum = sum;
+}
+
+static void *worker_main(void *arg) {
+    worker_t *w = (worker_t *)arg;
+    bind_thread_to_core(topo_cpu_for_thread(w->producer ? w->index : w->ctx->nprod + w->index));
+    pthread_barrier_wait(&w->ctx->barrier);
+    bench_span_begin(&w->span);
+    if (w->producer) producer_loop(w);
+    else consumer_loop(w);
+    bench_span_end(&w->span);
+    return NULL;
+}
+
+static worker_t workers[2 * MAX_THREADS];
+static uint32_t lat[MAX_THREADS * BENCH_LAT_SAMPLES];
+static int run_ok;
+
+static double run_once(void *arg) {
+    run_ctx_t *ctx = (run_ctx_t *)arg;
+    pthread_t tids[2 * MAX_THREADS];
+    int n = ctx->nprod + ctx->ncons;
+
+    ctx->q = ctx->ops->create(QUEUE_CAPACITY, ctx->nprod);
+    if (!ctx->q) {
+        perror("queue create");
+        exit(1);
+    }
+    ctx->producers_done = 0;
+    bench_spin_set_oversubscribed(n > topo_get()->ncpus);
+    pthread_barrier_init(&ctx->barrier, NULL, n + 1);
+    pc_region_begin();
+    for (int t = 0; t < n; t++) {
+        int producer = t < ctx->nprod;
+        uint32_t *ring = producer ? NULL : lat + (size_t)(t - ctx->nprod) * BENCH_LAT_SAMPLES;
+        workers[t] = (worker_t){ .ctx = ctx, .index = producer ? t : t - ctx->nprod, .producer = producer,
+                                 .lat = ring };
+        pthread_create(&tids[t], NULL, worker_main, &workers[t]);
+    }
+
+    pthread_barrier_wait(&ctx->barrier);
+    for (int t = 0; t < n; t++) pthread_join(tids[t], NULL);
+    pc_region_end();
+    pthread_barrier_destroy(&ctx->barrier);
+    ctx->ops->destroy(ctx->q);
+    double elapsed = bench_span_ms(&workers[0].span, n, sizeof(workers[0]));
+
+    long sent = 0, received = 0;
+    uint64_t sent_sum = 0, received_sum = 0;
+    for (int t = 0; t < n; t++) {
+        if (workers[t].producer) sent += workers[t].count, sent_sum += workers[t].sum;
+        else received += workers[t].count, received_sum += workers[t].sum;
+    }
+    if (sent != received || sent_sum != received_sum) run_ok = 0;
+    return elapsed;
+}
+
+typedef struct {
+    double mmsgs;
+    double p50_ns, p99_ns, p999_ns, max_ns;
+    int ok;
+} cell_t;
+
+static cell_t run_cell(const mpmc_ops_t *ops, int nprod, int ncons, long messages, double rate_mmsgs,
+                       bench_result_t *res) {
+    cell_t c = { 0 };
+    run_ok = 1;
+
+    run_ctx_t tput = { .ops = ops, .nprod = nprod, .ncons = ncons, .per_producer = messages / nprod };
+    bench_repeat(run_once, &tput, res);
+    c.mmsgs = tput.per_producer * nprod / (res->median_ms * 1e3);
+
+    // One paced run for the latency distribution
+    double gap_ns = nprod * 1e3 / rate_mmsgs;
+    run_ctx_t paced = { .ops = ops, .nprod = nprod, .ncons = ncons,
+                        .per_producer = LATENCY_MESSAGES / nprod,
+                        .gap_ticks = (uint64_t)(gap_ns / bench_tsc_ns_per_tick) };
+    if (paced.gap_ticks == 0) paced.gap_ticks = 1;
+    run_once(&paced);
+    c.ok = run_ok;
+
+    long nlat = 0;
+    for (int t = 0; t < ncons; t++) {
+        nlat = bench_lat_append(lat, nlat, workers[nprod + t].lat, workers[nprod + t].count);
+    }
+    double pct[4];
+    bench_tick_quantiles(lat, nlat, (const double[]){ 0.50, 0.99, 0.999, 1.0 }, 4, pct);
+    c.p50_ns = pct[0], c.p99_ns = pct[1], c.p999_ns = pct[2], c.max_ns = pct[3];
+    return c;
+}
+
+int main(int argc, char *argv[]) {
+    argc = bench_init(argc, argv, "mpmc_bench");
+    argc = bench_stats_init(argc, argv);
+    argc = topo_init_args(argc, argv);
+    int ncpus = topo_get()->ncpus;
+    int max_side = argc >= 2 ? atoi(argv[1]) : (ncpus / 2 > 1 ? ncpus / 2 : 1);
+    long messages = argc >= 3 ? atol(argv[2]) : DEFAULT_MESSAGES;
+    double rate = argc >= 4 ? atof(argv[3]) : DEFAULT_RATE_MMSGS;
+    if (max_side < 1 || max_side > MAX_THREADS || messages < max_side || rate <= 0) {
+        printf("Usage: %s [max_producers_and_consumers<=%d] [messages] [latency_rate_Mmsg/s]\n"
+               "        [--format text|json|csv] [--reps N] [--placement linear|cores|pack|spread]\n",
+               argv[0], MAX_THREADS);
+        return 1;
+    }
+    bench_tick_calibrate();
+
+    printf("=== MPMC Queue Comparison ===\n");
+    printf("Capacity %d, throughput: %ld messages per run; latency: %d messages at %.2f Mmsg/s offered\n",
+           QUEUE_CAPACITY, messages, LATENCY_MESSAGES, rate);
+    topo_print(topo_get());
+    if (2 * max_side > ncpus) {
+        printf("⚠️  Up to %d threads on %d CPUs: oversubscribed cells yield on every failed poll\n",
+               2 * max_side, ncpus);
+    }
+    printf("\n");
+    printf("%-10s %5s %5s %10s %10s %10s %10s %12s\n", "Queue", "Prod", "Cons", "Mmsg/s", "p50 ns",
+           "p99 ns", "p99.9 ns", "max ns");
+
+    for (int k = 0; k < NUM_MPMC_KINDS; k++) {
+        const mpmc_ops_t *ops = &mpmc_kinds[k];
+        // 1, 2, 4, ... and finally max_side itself, on both sides
+        for (int p = 1;; p *= 2) {
+            if (p > max_side) p = max_side;
+            for (int c = 1;; c *= 2) {
+                if (c > max_side) c = max_side;
+                bench_result_t res;
+                cell_t cell = run_cell(ops, p, c, messages, rate, &res);
+                printf("%-10s %5d %5d %10.2f %10.0f %10.0f %10.0f %12.0f%s\n", ops->name, p, c,
+                       cell.mmsgs, cell.p50_ns, cell.p99_ns, cell.p999_ns, cell.max_ns,
+                       cell.ok ? "" : "  MESSAGES LOST");
+                fflush(stdout);
+                bench_report_stats("mpmc", &res, (double)(messages / p) * p, 0,
+                                   "queue=%s,producers=%d,consumers=%d,latency_p50_ns=%.0f,"
+                                   "latency_p99_ns=%.0f,latency_p999_ns=%.0f,latency_max_ns=%.0f",
+                                   ops->name, p, c, cell.p50_ns, cell.p99_ns, cell.p999_ns, cell.max_ns);
+                if (c == max_side) break;
+            }
+            if (p == max_side) break;
+        }
+    }
+    printf("\nLatency: scheduled enqueue to dequeue, last %d per consumer of the paced run.\n"
+           "faa_seg is unbounded; the others hold at most %d messages and push back on producers.\n",
+           BENCH_LAT_SAMPLES, QUEUE_CAPACITY);
+    return 0;
+}
@@ -0,0 +1,386 @@
+#ifndef MPMC_QUEUES_H
+#define MPMC_QUEUES_H
+
+// Multi-producer/multi-consumer queues of nonzero 64-bit messages, behind one
+// ops table:
+//   mutex_cv   ring buffer under one pthread mutex, condvars for full/empty
+//   vyukov     Dmitry Vyukov's bounded array queue: per-cell sequence
+//              numbers, one CAS on the enqueue or dequeue position per op
+//   faa_seg    unbounded linked list of fixed arrays (LCRQ / FAAArrayQueue
+//              style): a fetch-and-add hands out slots, a swap claims them
+//   sharded    one ring per producer, consumers CAS the tail of whichever
+//              shard has data, starting from their home shard
+//
+// try_push/try_pop never block except in mutex_cv, where push waits for
+// space and pop waits for a message or mpmc_close. A failed try_pop after
+// every producer has finished means the queue is empty.
+//
+//   const mpmc_ops_t *ops = &mpmc_kinds[k];
+//   void *q = ops->create(capacity, nproducers);
+//   producer p: while (!ops->try_push(q, p, v)) ...;
+//   consumer c: if (ops->try_pop(q, c, &v)) ...;
+//   ops->close(q);  ops->destroy(q);
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MPMC_LINE 64
+#define MPMC_SEG_SLOTS 1024         // Slots per faa_seg segment
+#define MPMC_MAX_SHARDS 256
+
+// ---- mutex + condvar ring ----
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty, not_full;
+    uint64_t head, tail, mask;
+    int closed;
+    uint64_t *slots;
+} mpmc_cv_t;
+
+static void *cv_create(uint64_t capacity, int nproducers) {
+    (void)nproducers;
+    mpmc_cv_t *q = aligned_alloc(MPMC_LINE, sizeof(*q));
+    if (!q) return NULL;
+    q->slots = malloc(capacity * sizeof(uint64_t));
+    if (!q->slots) {
+        free(q);
+        return NULL;
+    }
+    pthread_mutex_init(&q->lock, NULL);
+    pthread_cond_init(&q->not_empty, NULL);
+    pthread_cond_init(&q->not_full, NULL);
+    q->head = q->tail = 0;
+    q->mask = capacity - 1;
+    q->closed = 0;
+    return q;
+}
+
+static void cv_destroy(void *p) {
+    mpmc_cv_t *q = p;
+    pthread_mutex_destroy(&q->lock);
+    pthread_cond_destroy(&q->not_empty);
+    pthread_cond_destroy(&q->not_full);
+    free(q->slots);
+    free(q);
+}
+
+static int cv_push(void *p, int producer, uint64_t v) {
+    mpmc_cv_t *q = p;
+    (void)producer;
+    pthread_mutex_lock(&q->lock);
+    while (q->head - q->tail > q->mask) pthread_cond_wait(&q->not_full, &q->lock);
+    q->slots[q->head++ & q->mask] = v;
+    pthread_cond_signal(&q->not_empty);
+    pthread_mutex_unlock(&q->lock);
+    return 1;
+}
+
+static int cv_pop(void *p, int consumer, uint64_t *v) {
+    mpmc_cv_t *q = p;
+    (void)consumer;
+    pthread_mutex_lock(&q->lock);
+    while (q->head == q->tail && !q->closed) pthread_cond_wait(&q->not_empty, &q->lock);
+    int got = q->head != q->tail;
+    if (got) {
+        *v = q->slots[q->tail++ & q->mask];
+        pthread_cond_signal(&q->not_full);
+    }
+    pthread_mutex_unlock(&q->lock);
+    return got;
+}
+
+static void cv_close(void *p) {
+    mpmc_cv_t *q = p;
+    pthread_mutex_lock(&q->lock);
+    q->closed = 1;
+    pthread_cond_broadcast(&q->not_empty);
+    pthread_mutex_unlock(&q->lock);
+}
+
+// ---- Vyukov bounded queue ----
+
+typedef struct {
+    uint64_t seq;               // == pos: free for enqueue; == pos + 1: full
+    uint64_t data;
+} vyukov_cell_t;
+
+typedef struct {
+    uint64_t enqueue_pos __attribute__((aligned(MPMC_LINE)));
+    uint64_t dequeue_pos __attribute__((aligned(MPMC_LINE)));
+    vyukov_cell_t *cells __attribute__((aligned(MPMC_LINE)));
+    uint64_t mask;
+} mpmc_vyukov_t;
+
+static void *vyukov_create(uint64_t capacity, int nproducers) {
+    (void)nproducers;
+    mpmc_vyukov_t *q = aligned_alloc(MPMC_LINE, sizeof(*q));
+    if (!q) return NULL;
+    q->cells = aligned_alloc(MPMC_LINE, capacity * sizeof(vyukov_cell_t));
+    if (!q->cells) {
+        free(q);
+        return NULL;
+    }
+    for (uint64_t i = 0; i < capacity; i++) q->cells[i].seq = i;
+    q->enqueue_pos = q->dequeue_pos = 0;
+    q->mask = capacity - 1;
+    return q;
+}
+
+static void vyukov_destroy(void *p) {
+    mpmc_vyukov_t *q = p;
+    free(q->cells);
+    free(q);
+}
+
+static int vyukov_push(void *p, int producer, uint64_t v) {
+    mpmc_vyukov_t *q = p;
+    (void)producer;
+    uint64_t pos = __atomic_load_n(&q->enqueue_pos, __ATOMIC_RELAXED);
+    for (;;) {
+        vyukov_cell_t *c = &q->cells[pos & q->mask];
+        int64_t dif = (int64_t)(__atomic_load_n(&c->seq, __ATOMIC_ACQUIRE) - pos);
+        if (dif == 0) {
+            if (__atomic_compare_exchange_n(&q->enqueue_pos, &pos, pos + 1, 1, __ATOMIC_RELAXED,
+                                            __ATOMIC_RELAXED)) {
+                c->data = v;
+                __atomic_store_n(&c->seq, pos + 1, __ATOMIC_RELEASE);
+                return 1;
+            }
+        } else if (dif < 0) {
+            return 0;           // Full: the cell still holds last lap's message
+        } else {
+            pos = __atomic_load_n(&q->enqueue_pos, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+static int vyukov_pop(void *p, int consumer, uint64_t *v) {
+    mpmc_vyukov_t *q = p;
+    (void)consumer;
+    uint64_t pos = __atomic_load_n(&q->dequeue_pos, __ATOMIC_RELAXED);
+    for (;;) {
+        vyukov_cell_t *c = &q->cells[pos & q->mask];
+        int64_t dif = (int64_t)(__atomic_load_n(&c->seq, __ATOMIC_ACQUIRE) - (pos + 1));
+        if (dif == 0) {
+            if (__atomic_compare_exchange_n(&q->dequeue_pos, &pos, pos + 1, 1, __ATOMIC_RELAXED,
+                                            __ATOMIC_RELAXED)) {
+                *v = c->data;
+                __atomic_store_n(&c->seq, pos + q->mask + 1, __ATOMIC_RELEASE);
+                return 1;
+            }
+        } else if (dif < 0) {
+            return 0;           // Empty
+        } else {
+            pos = __atomic_load_n(&q->dequeue_pos, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+static void mpmc_close_nop(void *p) {
+    (void)p;
+}
+
+// ---- Segmented fetch-and-add queue ----
+// Slot states: 0 empty, MPMC_TAKEN poisoned by a dequeuer that got there
+// first (the enqueuer then takes another slot), anything else a message.
+// Segments are only unlinked from head, never freed before destroy, so no
+// reclamation scheme is needed; memory grows with messages sent.
+
+#define MPMC_TAKEN UINT64_MAX
+
+typedef struct faa_seg {
+    uint64_t enq_idx __attribute__((aligned(MPMC_LINE)));
+    uint64_t deq_idx __attribute__((aligned(MPMC_LINE)));
+    struct faa_seg *next __attribute__((aligned(MPMC_LINE)));
+    struct faa_seg *all;        // Allocation chain for destroy
+    uint64_t slots[MPMC_SEG_SLOTS] __attribute__((aligned(MPMC_LINE)));
+} faa_seg_t;
+
+typedef struct {
+    faa_seg_t *head __attribute__((aligned(MPMC_LINE)));
+    faa_seg_t *tail __attribute__((aligned(MPMC_LINE)));
+    faa_seg_t *first __attribute__((aligned(MPMC_LINE)));
+    pthread_mutex_t alloc_lock; // Guards first/all only
+} mpmc_faa_t;
+
+static faa_seg_t *faa_seg_new(mpmc_faa_t *q) {
+    faa_seg_t *s = aligned_alloc(MPMC_LINE, sizeof(*s));
+    if (!s) abort();
+    memset(s, 0, sizeof(*s));
+    pthread_mutex_lock(&q->alloc_lock);
+    s->all = q->first;
+    q->first = s;
+    pthread_mutex_unlock(&q->alloc_lock);
+    return s;
+}
+
+static void *faa_create(uint64_t capacity, int nproducers) {
+    (void)capacity;
+    (void)nproducers;
+    mpmc_faa_t *q = aligned_alloc(MPMC_LINE, sizeof(*q));
+    if (!q) return NULL;
+    q->first = NULL;
+    pthread_mutex_init(&q->alloc_lock, NULL);
+    q->head = q->tail = faa_seg_new(q);
+    return q;
+}
+
+static void faa_destroy(void *p) {
+    mpmc_faa_t *q = p;
+    for (faa_seg_t *s = q->first, *n; s; s = n) {
+        n = s->all;
+        free(s);
+    }
+    pthread_mutex_destroy(&q->alloc_lock);
+    free(q);
+}
+
+static int faa_push(void *p, int producer, uint64_t v) {
+    mpmc_faa_t *q = p;
+    (void)producer;
+    for (;;) {
+        faa_seg_t *t = __atomic_load_n(&q->tail, __ATOMIC_ACQUIRE);
+        uint64_t idx = __atomic_fetch_add(&t->enq_idx, 1, __ATOMIC_RELAXED);
+        if (idx < MPMC_SEG_SLOTS) {
+            uint64_t expected = 0;
+            if (__atomic_compare_exchange_n(&t->slots[idx], &expected, v, 0, __ATOMIC_RELEASE,
+                                            __ATOMIC_RELAXED)) {
+                return 1;
+            }
+            continue;           // Poisoned by a dequeuer; take a fresh slot
+        }
+        // Segment full: link a new one (or help whoever did) and move tail
+        faa_seg_t *next = __atomic_load_n(&t->next, __ATOMIC_ACQUIRE);
+        if (!next) {
+            faa_seg_t *s = faa_seg_new(q);
+            s->enq_idx = 1;
+            s->slots[0] = v;
+            if (__atomic_compare_exchange_n(&t->next, &next, s, 0, __ATOMIC_RELEASE,
+                                            __ATOMIC_ACQUIRE)) {
+                __atomic_compare_exchange_n(&q->tail, &t, s, 0, __ATOMIC_RELEASE, __ATOMIC_RELAXED);
+                return 1;
+            }
+            // Lost the race; the unused segment stays on the chain until destroy
+        }
+        __atomic_compare_exchange_n(&q->tail, &t, next, 0, __ATOMIC_RELEASE, __ATOMIC_RELAXED);
+    }
+}
+
+static int faa_pop(void *p, int consumer, uint64_t *v) {
+    mpmc_faa_t *q = p;
+    (void)consumer;
+    for (;;) {
+        faa_seg_t *h = __atomic_load_n(&q->head, __ATOMIC_ACQUIRE);
+        uint64_t deq = __atomic_load_n(&h->deq_idx, __ATOMIC_RELAXED);
+        uint64_t enq = __atomic_load_n(&h->enq_idx, __ATOMIC_RELAXED);
+        if (deq >= enq && !__atomic_load_n(&h->next, __ATOMIC_ACQUIRE)) return 0;
+        uint64_t idx = __atomic_fetch_add(&h->deq_idx, 1, __ATOMIC_RELAXED);
+        if (idx >= MPMC_SEG_SLOTS) {
+            faa_seg_t *next = __atomic_load_n(&h->next, __ATOMIC_ACQUIRE);
+            if (!next) return 0;
+            __atomic_compare_exchange_n(&q->head, &h, next, 0, __ATOMIC_RELEASE, __ATOMIC_RELAXED);
+            continue;
+        }
+        uint64_t x = __atomic_exchange_n(&h->slots[idx], MPMC_TAKEN, __ATOMIC_ACQUIRE);
+        if (x != 0) {
+            *v = x;
+            return 1;
+        }
+        // Beat the enqueuer to this slot and poisoned it; try the next one
+    }
+}
+
+// ---- Sharded per-producer rings ----
+// Producer p alone advances shard p's head; consumers race on its tail with
+// CAS. A consumer reads the slot before the CAS, which is safe because the
+// producer can only reuse that slot after tail has moved past it.
+
+typedef struct {
+    uint64_t head __attribute__((aligned(MPMC_LINE)));
+    uint64_t tail __attribute__((aligned(MPMC_LINE)));
+    uint64_t *slots __attribute__((aligned(MPMC_LINE)));
+    uint64_t cached_tail;       // Producer-private
+} mpmc_shard_t;
+
+typedef struct {
+    int nshards;
+    uint64_t mask;
+    mpmc_shard_t shards[];
+} mpmc_sharded_t;
+
+static void *sharded_create(uint64_t capacity, int nproducers) {
+    if (nproducers < 1 || nproducers > MPMC_MAX_SHARDS) return NULL;
+    // Same total capacity as the single queues, split across shards
+    uint64_t per = capacity / nproducers;
+    uint64_t cap = 2;
+    while (cap * 2 <= per) cap *= 2;
+    mpmc_sharded_t *q = aligned_alloc(MPMC_LINE, sizeof(*q) + nproducers * sizeof(mpmc_shard_t));
+    if (!q) return NULL;
+    q->nshards = nproducers;
+    q->mask = cap - 1;
+    for (int i = 0; i < nproducers; i++) {
+        mpmc_shard_t *s = &q->shards[i];
+        s->head = s->tail = s->cached_tail = 0;
+        s->slots = aligned_alloc(MPMC_LINE, cap * sizeof(uint64_t));
+        if (!s->slots) abort();
+    }
+    return q;
+}
+
+static void sharded_destroy(void *p) {
+    mpmc_sharded_t *q = p;
+    for (int i = 0; i < q->nshards; i++) free(q->shards[i].slots);
+    free(q);
+}
+
+static int sharded_push(void *p, int producer, uint64_t v) {
+    mpmc_sharded_t *q = p;
+    mpmc_shard_t *s = &q->shards[producer];
+    uint64_t h = s->head;
+    if (h - s->cached_tail > q->mask) {
+        s->cached_tail = __atomic_load_n(&s->tail, __ATOMIC_ACQUIRE);
+        if (h - s->cached_tail > q->mask) return 0;
+    }
+    __atomic_store_n(&s->slots[h & q->mask], v, __ATOMIC_RELAXED);
+    __atomic_store_n(&s->head, h + 1, __ATOMIC_RELEASE);
+    return 1;
+}
+
+static int sharded_pop(void *p, int consumer, uint64_t *v) {
+    mpmc_sharded_t *q = p;
+    for (int i = 0; i < q->nshards; i++) {
+        mpmc_shard_t *s = &q->shards[(consumer + i) % q->nshards];
+        uint64_t t = __atomic_load_n(&s->tail, __ATOMIC_ACQUIRE);
+        while (t != __atomic_load_n(&s->head, __ATOMIC_ACQUIRE)) {
+            uint64_t x = __atomic_load_n(&s->slots[t & q->mask], __ATOMIC_RELAXED);
+            if (__atomic_compare_exchange_n(&s->tail, &t, t + 1, 0, __ATOMIC_RELEASE,
+                                            __ATOMIC_ACQUIRE)) {
+                *v = x;
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+typedef struct {
+    const char *name;
+    void *(*create)(uint64_t capacity, int nproducers);  // capacity: power of two
+    void (*destroy)(void *q);
+    int (*try_push)(void *q, int producer, uint64_t v);
+    int (*try_pop)(void *q, int consumer, uint64_t *v);
+    void (*close)(void *q);     // All producers done; wakes blocked consumers
+} mpmc_ops_t;
+
+static const mpmc_ops_t mpmc_kinds[] = {
+    { "mutex_cv", cv_create,      cv_destroy,      cv_push,      cv_pop,      cv_close },
+    { "vyukov",   vyukov_create,  vyukov_destroy,  vyukov_push,  vyukov_pop,  mpmc_close_nop },
+    { "faa_seg",  faa_create,     faa_destroy,     faa_push,     faa_pop,     mpmc_close_nop },
+    { "sharded",  sharded_create, sharded_destroy, sharded_push, sharded_pop, mpmc_close_nop },
+};
+#define NUM_MPMC_KINDS (int)(sizeof(mpmc_kinds) / sizeof(mpmc_kinds[0]))
+
+#endif
@@ -3,7 +3,7 @@ set -e
 
 # 编译优化版本
 echo "🔨 Compiling enhanced cache performance demo..."
-gcc -O2 -pthread -D_GNU_SOURCE -o cache_test cache_pingpong_perf.c
+gcc -O2 -pthread -D_GNU_SOURCE -o cache_test cache_pingpong_perf.c -lm
 
 # 检查CPU信息
 echo "💻 System Information:"
@@ -6,8 +6,14 @@ echo "=========================================="
 
 # 编译所有测试
 echo "🔨 Compiling tests..."
-gcc -O2 -pthread -D_GNU_SOURCE -o cache_test cache_pingpong_perf.c
-gcc -O2 -pthread -D_GNU_SOURCE -o extreme_test extreme_cache_test.c
+gcc -O2 -pthread -D_GNU_SOURCE -o cache_test cache_pingpong_perf.c -lm
+gcc -O2 -pthread -D_GNU_SOURCE -o extreme_test extreme_cache_test.c -lm
+gcc -O2 -pthread -D_GNU_SOURCE -o core_to_core core_to_core.c -lm
+gcc -O2 -g -pthread -D_GNU_SOURCE -o fs_detect fs_detect.c
+gcc -O2 -pthread -D_GNU_SOURCE -o spsc_bench spsc_bench.c -lm
+gcc -O2 -pthread -D_GNU_SOURCE -o mpmc_bench mpmc_bench.c -lm
+gcc -O2 -pthread -D_GNU_SOURCE -o wait_bench wait_bench.c -lm
+gcc -O2 -pthread -D_GNU_SOURCE -o wakeup_bench wakeup_bench.c -lm
 
 # 系统信息
 echo "💻 System Information:"
@@ -27,6 +33,36 @@ echo "=== Test Suite 2: Extreme Cache Effects ==="
 ./extreme_test
 echo
 
+# 核间延迟矩阵：SMT 兄弟核、CCX/CCD 边界、跨 socket 一目了然
+echo "=== Test Suite 3: Core-to-Core Latency Matrix ==="
+./core_to_core
+echo
+
+# 基于 PEBS/IBS 采样自动定位伪共享（无精确采样时回退到上面的演示程序）
+echo "=== Test Suite 4: False Sharing Detector ==="
+./fs_detect || true
+echo
+
+# 从 ping-pong 的标志位交接演进到无锁 SPSC 环形队列：吞吐与单向延迟对比
+echo "=== Test Suite 5: SPSC Ring vs Flag Handoff ==="
+./spsc_bench
+echo
+
+# 多生产者/多消费者队列：互斥锁+条件变量、Vyukov、分段 FAA、按生产者分片
+echo "=== Test Suite 6: MPMC Queue Comparison ==="
+./mpmc_bench
+echo
+
+# 等待策略：纯自旋、pause、指数退避、yield、自旋后 futex、umwait/tpause 的延迟与 CPU 消耗
+echo "=== Test Suite 7: Wait Strategies ==="
+./wait_bench
+echo
+
+# 唤醒延迟：futex、eventfd、pipe、条件变量、信号量、信号，按同核/SMT/同 L3/跨 socket 分别测量
+echo "=== Test Suite 8: Wakeup Latency ==="
+./wakeup_bench
+echo
+
 # Perf分析
 if command -v perf >/dev/null 2>&1; then
     echo "=== Detailed Cache Analysis ==="
@@ -0,0 +1,291 @@
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bind_threads.h"
+#include "../common/bench_stats.h"
+#include "spsc_ring.h"
+
+#define CACHE_LINE_SIZE 64
+#define DEFAULT_MESSAGES 10000000   // Per throughput run
+#define LATENCY_MESSAGES 200000     // Per latency run
+#define DEFAULT_GAP_NS 2000         // Producer pacing in latency runs
+#define RING_CAPACITY 4096
+#define RING_BATCH 32
+
+// Producer -> consumer message passing between two pinned threads:
+//   flag     the extreme_cache_test ping-pong handoff: one value plus a flag,
+//            busy-waiting with __sync_synchronize() on every step
+//   lamport  ring with shared head/tail, acquire/release, reloaded every op
+//   spsc     spsc_ring.h with cached remote indices, batch 1
+//   spsc_b32 spsc_ring.h publishing every 32 messages (or when idle)
+// Throughput: back-to-back messages, checked for order. Latency: the producer
+// sends a cycle-counter stamp every gap ns and flushes; the consumer records
+// now - stamp (one-way, assumes a synchronized TSC / arm64 generic timer).
+
+typedef struct {
+    volatile uint64_t value;
+    volatile int flag;
+} __attribute__((aligned(CACHE_LINE_SIZE))) flag_chan_t;
+
+typedef struct {
+    uint64_t head __attribute__((aligned(CACHE_LINE_SIZE)));
+    uint64_t tail __attribute__((aligned(CACHE_LINE_SIZE)));
+    uint64_t *slots __attribute__((aligned(CACHE_LINE_SIZE)));
+    uint64_t mask;
+} lamport_ring_t;
+
+typedef struct {
+    flag_chan_t flag;
+    lamport_ring_t lamport;
+    spsc_ring_t spsc;
+} channels_t;
+
+static channels_t chan;
+
+// ---- flag handoff ----
+
+static inline void flag_send(uint64_t v) {
+    long spins = 0;
+    while (chan.flag.flag != 0) {
+        // Busy wait - this causes maximum cache line bouncing
+        __sync_synchronize();
+        bench_spin_pause(&spins);
+    }
+    chan.flag.value = v;
+    __sync_synchronize();
+    chan.flag.flag = 1;
+}
+
+static inline uint64_t flag_recv(void) {
+    long spins = 0;
+    while (chan.flag.flag != 1) {
+        __sync_synchronize();
+        bench_spin_pause(&spins);
+    }
+    uint64_t v = chan.flag.value;
+    __sync_synchronize();
+    chan.flag.flag = 0;
+    return v;
+}
+
+static inline void flag_flush(void) {}
+
+// ---- Lamport ring ----
+
+static inline void lamport_send(uint64_t v) {
+    lamport_ring_t *r = &chan.lamport;
+    uint64_t h = __atomic_load_n(&r->head, __ATOMIC_RELAXED);
+    long spins = 0;
+    while (h - __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE) > r->mask) bench_spin_pause(&spins);
+    r->slots[h & r->mask] = v;
+    __atomic_store_n(&r->head, h + 1, __ATOMIC_RELEASE);
+}
+
+static inline uint64_t lamport_recv(void) {
+    lamport_ring_t *r = &chan.lamport;
+    uint64_t t = __atomic_load_n(&r->tail, __ATOMIC_RELAXED);
+    long spins = 0;
+    while (__atomic_load_n(&r->head, __ATOMIC_ACQUIRE) == t) bench_spin_pause(&spins);
+    uint64_t v = r->slots[t & r->mask];
+    __atomic_store_n(&r->tail, t + 1, __ATOMIC_RELEASE);
+    return v;
+}
+
+static inline void lamport_flush(void) {}
+
+// ---- spsc_ring.h ----
+
+static inline void spsc_send(uint64_t v) {
+    long spins = 0;
+    while (!spsc_try_push(&chan.spsc, v)) bench_spin_pause(&spins);
+}
+
+static inline uint64_t spsc_recv(void) {
+    uint64_t v;
+    long spins = 0;
+    while (!spsc_try_pop(&chan.spsc, &v)) bench_spin_pause(&spins);
+    return v;
+}
+
+static inline void spsc_idle(void) { spsc_flush(&chan.spsc); }
+
+// ---- Generic producer/consumer loops, instantiated per channel ----
+
+typedef struct {
+    long messages;
+    uint64_t gap_ticks;         // 0: throughput run; else pace and stamp
+    uint32_t *lat;              // Latency run: one-way latency per message, ticks
+    long errors;                // Throughput run: out-of-order messages
+    pthread_barrier_t barrier;
+} run_ctx_t;
+
+#define DEFINE_LOOPS(name, send, recv, idle)                                        \
+    static void name##_producer(run_ctx_t *ctx) {                                   \
+        uint64_t last = 0;                                                          \
+        for (long i = 0; i < ctx->messages; i++) {                                  \
+            if (ctx->gap_ticks) {                                                   \
+                uint64_t now;                                                       \
+                while ((now = bench_cycle_counter()) - last < ctx->gap_ticks) {     \
+                }                                                                   \
+                last = now;                                                         \
+                send(now);                                                          \
+                idle();                                                             \
+            } else {                                                                \
+                send((uint64_t)i);                                                  \
+            }                                                                       \
+        }                                                                           \
+        idle();                                                                     \
+    }                                                                               \
+    static void name##_consumer(run_ctx_t *ctx) {                                   \
+        long errors = 0;                                                            \
+        for (long i = 0; i < ctx->messages; i++) {                                  \
+            uint64_t v = recv();                                                    \
+            if (ctx->gap_ticks) {                                                   \
+                uint64_t dt = bench_cycle_counter() - v;                            \
+                ctx->lat[i] = dt > UINT32_MAX ? UINT32_MAX : (uint32_t)dt;          \
+            } else {                                                                \
+                errors += v != (uint64_t)i;                                         \
+            }                                                                       \
+        }                                                                           \
+        ctx->errors = errors;                                                       \
+    }
+
+DEFINE_LOOPS(flag, flag_send, flag_recv, flag_flush)
+DEFINE_LOOPS(lamport, lamport_send, lamport_recv, lamport_flush)
+DEFINE_LOOPS(spsc, spsc_send, spsc_recv, spsc_idle)
+
+typedef struct {
+    const char *name;
+    void (*producer)(run_ctx_t *ctx);
+    void (*consumer)(run_ctx_t *ctx);
+    uint64_t batch;             // spsc_ring batch; 0 = not an spsc_ring variant
+} channel_impl_t;
+
+static const channel_impl_t impls[] = {
+    { "flag",     flag_producer,    flag_consumer,    0 },
+    { "lamport",  lamport_producer, lamport_consumer, 0 },
+    { "spsc",     spsc_producer,    spsc_consumer,    1 },
+    { "spsc_b32", spsc_producer,    spsc_consumer,    RING_BATCH },
+};
+#define NUM_IMPLS (int)(sizeof(impls) / sizeof(impls[0]))
+
+typedef struct {
+    const channel_impl_t *impl;
+    run_ctx_t *ctx;
+    int producer;
+    bench_span_t span;
+} thread_arg_t;
+
+static void *channel_thread(void *arg) {
+    thread_arg_t *a = (thread_arg_t *)arg;
+    bind_thread_to_core(topo_cpu_for_thread(a->producer ? 0 : 1));
+    pthread_barrier_wait(&a->ctx->barrier);
+    bench_span_begin(&a->span);
+    if (a->producer) a->impl->producer(a->ctx);
+    else a->impl->consumer(a->ctx);
+    bench_span_end(&a->span);
+    return NULL;
+}
+
+static void reset_channels(const channel_impl_t *impl) {
+    memset(&chan.flag, 0, sizeof(chan.flag));
+    chan.lamport.head = chan.lamport.tail = 0;
+    if (impl->batch) {
+        spsc_destroy(&chan.spsc);
+        spsc_init(&chan.spsc, RING_CAPACITY, impl->batch);
+    }
+}
+
+typedef struct {
+    const channel_impl_t *impl;
+    run_ctx_t ctx;
+} bench_arg_t;
+
+static double run_once(void *arg) {
+    bench_arg_t *b = (bench_arg_t *)arg;
+    pthread_t tp, tc;
+    thread_arg_t args[2] = { { b->impl, &b->ctx, 1, { 0, 0 } }, { b->impl, &b->ctx, 0, { 0, 0 } } };
+
+    reset_channels(b->impl);
+    pthread_barrier_init(&b->ctx.barrier, NULL, 3);
+    pc_region_begin();
+    pthread_create(&tc, NULL, channel_thread, &args[1]);
+    pthread_create(&tp, NULL, channel_thread, &args[0]);
+    pthread_barrier_wait(&b->ctx.barrier);
+    pthread_join(tp, NULL);
+    pthread_join(tc, NULL);
+    pc_region_end();
+    pthread_barrier_destroy(&b->ctx.barrier);
+    return bench_span_ms(&args[0].span, 2, sizeof(args[0]));
+}
+
+int main(int argc, char *argv[]) {
+    argc = bench_init(argc, argv, "spsc_bench");
+    argc = bench_stats_init(argc, argv);
+    argc = topo_init_args(argc, argv);
+    long messages = argc >= 2 ? atol(argv[1]) : DEFAULT_MESSAGES;
+    double gap_ns = argc >= 3 ? atof(argv[2]) : DEFAULT_GAP_NS;
+    if (messages < 1 || gap_ns <= 0) {
+        printf("Usage: %s [messages] [latency_gap_ns] [--format text|json|csv] [--reps N]\n"
+               "        [--placement linear|cores|pack|spread]\n", argv[0]);
+        return 1;
+    }
+    bench_tick_calibrate();
+
+    chan.lamport.slots = aligned_alloc(CACHE_LINE_SIZE, RING_CAPACITY * sizeof(uint64_t));
+    uint32_t *lat = malloc(LATENCY_MESSAGES * sizeof(uint32_t));
+    if (!chan.lamport.slots || !lat || spsc_init(&chan.spsc, RING_CAPACITY, 1) != 0) {
+        perror("malloc");
+        return 1;
+    }
+    chan.lamport.mask = RING_CAPACITY - 1;
+
+    const topo_t *topo = topo_get();
+    int cp = topo_cpu_for_thread(0), cc = topo_cpu_for_thread(1);
+    printf("=== SPSC Queue vs Flag Handoff ===\n");
+    topo_print(topo);
+    printf("Producer on CPU %d, consumer on CPU %d (%s); ring %d slots\n", cp, cc,
+           topo_relation_names[topo_relation(topo, cp, cc)], RING_CAPACITY);
+    if (cp == cc) {
+        printf("⚠️  Producer and consumer share one CPU: waiters yield on every empty poll\n");
+        bench_spin_set_oversubscribed(1);
+        if (argc < 2) messages = LATENCY_MESSAGES;     // Each flag handoff costs a context switch
+    }
+    printf("Throughput: %ld messages per run; latency: %d messages, one every %.0f ns\n\n",
+           messages, LATENCY_MESSAGES, gap_ns);
+
+    printf("%-10s %12s %12s %10s %10s %10s %10s\n", "Channel", "Mmsg/s", "ns/msg", "p50 ns",
+           "p99 ns", "p99.9 ns", "max ns");
+    for (int i = 0; i < NUM_IMPLS; i++) {
+        const channel_impl_t *impl = &impls[i];
+
+        bench_arg_t tput = { impl, { .messages = messages } };
+        bench_result_t res;
+        bench_repeat(run_once, &tput, &res);
+        double mmsgs = messages / (res.median_ms * 1e3);
+
+        // One paced run for the latency distribution
+        bench_arg_t paced = { impl, { .messages = LATENCY_MESSAGES,
+                                      .gap_ticks = (uint64_t)(gap_ns / bench_tsc_ns_per_tick),
+                                      .lat = lat } };
+        run_once(&paced);
+        double pct[4];
+        bench_tick_quantiles(lat, LATENCY_MESSAGES, (const double[]){ 0.50, 0.99, 0.999, 1.0 }, 4, pct);
+        double p50 = pct[0], p99 = pct[1], p999 = pct[2], max = pct[3];
+
+        printf("%-10s %12.2f %12.2f %10.0f %10.0f %10.0f %10.0f%s\n", impl->name, mmsgs,
+               res.median_ms * 1e6 / messages, p50, p99, p999, max,
+               tput.ctx.errors ? "  OUT OF ORDER" : "");
+        bench_report_stats("spsc", &res, messages, messages * sizeof(uint64_t),
+                           "channel=%s,batch=%lu,latency_p50_ns=%.0f,latency_p99_ns=%.0f,"
+                           "latency_p999_ns=%.0f", impl->name, (unsigned long)impl->batch, p50, p99, p999);
+    }
+    printf("\nns/msg is inverse throughput; latency is one-way producer stamp -> consumer receipt.\n");
+
+    spsc_destroy(&chan.spsc);
+    free(chan.lamport.slots);
+    free(lat);
+    return 0;
+}
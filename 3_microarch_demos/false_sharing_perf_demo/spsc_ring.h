@@ -0,0 +1,106 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+// Bounded single-producer/single-consumer ring of 64-bit messages.
+//   - head (published by the producer) and tail (published by the consumer)
+//     live on their own cache lines, apart from each side's private state
+//   - each side keeps a cached copy of the other's index and only reloads it
+//     when the ring looks full/empty, so the shared lines move rarely
+//   - indices are published every `batch` operations (and whenever a side
+//     would otherwise wait), with release stores paired with acquire loads;
+//     no full fences
+//
+//   spsc_ring_t r;
+//   spsc_init(&r, 1 << 16, 32);
+//   producer: while (!spsc_try_push(&r, v)) ...;  spsc_flush(&r) when idle
+//   consumer: while (!spsc_try_pop(&r, &v)) ...;
+//   spsc_destroy(&r);
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#define SPSC_LINE 64
+
+typedef struct {
+    // Published indices, each alone on its line
+    uint64_t head __attribute__((aligned(SPSC_LINE)));  // Written by producer
+    uint64_t tail __attribute__((aligned(SPSC_LINE)));  // Written by consumer
+
+    // Producer-private
+    uint64_t write_idx __attribute__((aligned(SPSC_LINE)));
+    uint64_t published_head;    // Last value stored to head
+    uint64_t cached_tail;
+    uint64_t *p_slots;
+    uint64_t p_mask, p_batch;
+
+    // Consumer-private
+    uint64_t read_idx __attribute__((aligned(SPSC_LINE)));
+    uint64_t published_tail;
+    uint64_t cached_head;
+    uint64_t *c_slots;
+    uint64_t c_mask, c_batch;
+} spsc_ring_t;
+
+// capacity must be a power of two; batch is clamped to [1, capacity / 2]
+static inline int spsc_init(spsc_ring_t *r, uint64_t capacity, uint64_t batch) {
+    if (capacity < 2 || (capacity & (capacity - 1))) return -1;
+    uint64_t *slots = aligned_alloc(SPSC_LINE, capacity * sizeof(uint64_t));
+    if (!slots) return -1;
+    if (batch < 1) batch = 1;
+    if (batch > capacity / 2) batch = capacity / 2;
+    r->head = r->tail = 0;
+    r->write_idx = r->published_head = r->cached_tail = 0;
+    r->read_idx = r->published_tail = r->cached_head = 0;
+    r->p_slots = r->c_slots = slots;
+    r->p_mask = r->c_mask = capacity - 1;
+    r->p_batch = r->c_batch = batch;
+    return 0;
+}
+
+static inline void spsc_destroy(spsc_ring_t *r) {
+    free(r->p_slots);
+}
+
+// Make every pushed message visible to the consumer
+static inline void spsc_flush(spsc_ring_t *r) {
+    r->published_head = r->write_idx;
+    __atomic_store_n(&r->head, r->write_idx, __ATOMIC_RELEASE);
+}
+
+static inline int spsc_try_push(spsc_ring_t *r, uint64_t v) {
+    if (r->write_idx - r->cached_tail > r->p_mask) {
+        r->cached_tail = __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+        if (r->write_idx - r->cached_tail > r->p_mask) {
+            // Full: make sure the consumer can drain it
+            if (r->published_head != r->write_idx) spsc_flush(r);
+            return 0;
+        }
+    }
+    r->p_slots[r->write_idx & r->p_mask] = v;
+    r->write_idx++;
+    if (r->write_idx - r->published_head >= r->p_batch) spsc_flush(r);
+    return 1;
+}
+
+// Hand consumed slots back to the producer
+static inline void spsc_release(spsc_ring_t *r) {
+    r->published_tail = r->read_idx;
+    __atomic_store_n(&r->tail, r->read_idx, __ATOMIC_RELEASE);
+}
+
+static inline int spsc_try_pop(spsc_ring_t *r, uint64_t *v) {
+    if (r->read_idx == r->cached_head) {
+        r->cached_head = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+        if (r->read_idx == r->cached_head) {
+            // Empty: return everything before waiting
+            if (r->published_tail != r->read_idx) spsc_release(r);
+            return 0;
+        }
+    }
+    *v = r->c_slots[r->read_idx & r->c_mask];
+    r->read_idx++;
+    if (r->read_idx - r->published_tail >= r->c_batch) spsc_release(r);
+    return 1;
+}
+
+#endif
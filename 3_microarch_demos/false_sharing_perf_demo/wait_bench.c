@@ -0,0 +1,148 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "bind_threads.h"
+#include "../common/bench_stats.h"
+#include "waiters.h"
+
+#define DEFAULT_ROUNDS 20000        // Handoffs per (waiter, gap) cell, at most
+#define CELL_BUDGET_US 200000       // Fewer rounds for long gaps so a cell stays ~200 ms
+
+// Handoff latency vs CPU burned for every waiter in waiters.h. The initiator
+// waits for the previous handoff's ack, busy-waits `gap` us, stamps the
+// cycle counter and wakes the responder; the responder records
+// now - stamp and acks. Both directions use the waiter under test.
+// Small gaps favour spinning; long gaps are where a waiter must decide to
+// park, and where the responder's CPU time shows what spinning costs.
+
+static const int gaps_us[] = { 0, 1, 10, 100, 1000 };
+#define NUM_GAPS (int)(sizeof(gaps_us) / sizeof(gaps_us[0]))
+
+typedef struct {
+    const waiter_ops_t *ops;
+    long rounds;
+    uint64_t gap_ticks;
+    wait_word_t ping, pong;
+    uint64_t stamp __attribute__((aligned(WAITER_LINE)));
+    uint32_t *lat;              // Responder: one-way wake latency per round, ticks
+    double cpu_ms;              // Responder thread CPU time
+    pthread_barrier_t barrier;
+} handoff_ctx_t;
+
+static double thread_cpu_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static void *initiator(void *arg) {
+    handoff_ctx_t *c = (handoff_ctx_t *)arg;
+    bind_thread_to_core(topo_cpu_for_thread(0));
+    pthread_barrier_wait(&c->barrier);
+    for (uint32_t r = 0; r < c->rounds; r++) {
+        uint64_t start = bench_cycle_counter();
+        while (bench_cycle_counter() - start < c->gap_ticks) {
+        }
+        __atomic_store_n(&c->stamp, bench_cycle_counter(), __ATOMIC_RELAXED);
+        c->ops->wake(&c->ping, r + 1);
+        c->ops->wait(&c->pong, r);
+    }
+    return NULL;
+}
+
+static void *responder(void *arg) {
+    handoff_ctx_t *c = (handoff_ctx_t *)arg;
+    bind_thread_to_core(topo_cpu_for_thread(1));
+    pthread_barrier_wait(&c->barrier);
+    double cpu0 = thread_cpu_ms();
+    for (uint32_t r = 0; r < c->rounds; r++) {
+        c->ops->wait(&c->ping, r);
+        uint64_t dt = bench_cycle_counter() - __atomic_load_n(&c->stamp, __ATOMIC_RELAXED);
+        c->lat[r] = dt > UINT32_MAX ? UINT32_MAX : (uint32_t)dt;
+        c->ops->wake(&c->pong, r + 1);
+    }
+    c->cpu_ms = thread_cpu_ms() - cpu0;
+    return NULL;
+}
+
+int main(int argc, char *argv[]) {
+    argc = bench_init(argc, argv, "wait_bench");
+    argc = bench_stats_init(argc, argv);
+    argc = topo_init_args(argc, argv);
+    long max_rounds = argc >= 2 ? atol(argv[1]) : DEFAULT_ROUNDS;
+    if (max_rounds < 1) {
+        printf("Usage: %s [rounds] [--format text|json|csv] [--placement linear|cores|pack|spread]\n",
+               argv[0]);
+        return 1;
+    }
+    bench_tick_calibrate();
+
+    const topo_t *topo = topo_get();
+    int c0 = topo_cpu_for_thread(0), c1 = topo_cpu_for_thread(1);
+    printf("=== Wait Strategy Benchmark ===\n");
+    topo_print(topo);
+    printf("Initiator on CPU %d, responder on CPU %d (%s); WAITPKG %s\n", c0, c1,
+           topo_relation_names[topo_relation(topo, c0, c1)], waitpkg_available() ? "yes" : "no");
+    if (c0 == c1) printf("⚠️  Both threads share one CPU: waiters that never release it are skipped\n");
+    printf("\n%-11s %7s %7s %10s %10s %10s %12s %8s\n", "Waiter", "Gap us", "Rounds", "p50 ns",
+           "p99 ns", "max ns", "CPU us/op", "CPU %");
+
+    uint32_t *lat = malloc(max_rounds * sizeof(uint32_t));
+    if (!lat) {
+        perror("malloc");
+        return 1;
+    }
+    for (int k = 0; k < NUM_WAITER_KINDS; k++) {
+        const waiter_ops_t *ops = &waiter_kinds[k];
+        if (!ops->available()) {
+            printf("%-11s (not supported on this CPU)\n", ops->name);
+            continue;
+        }
+        if (c0 == c1 && !ops->releases_cpu) {
+            // Every handoff would wait for a preemption, a scheduler quantum
+            printf("%-11s (skipped: spins on the CPU the other thread needs)\n", ops->name);
+            continue;
+        }
+        for (int g = 0; g < NUM_GAPS; g++) {
+            long rounds = gaps_us[g] ? CELL_BUDGET_US / gaps_us[g] : max_rounds;
+            if (rounds > max_rounds) rounds = max_rounds;
+            static handoff_ctx_t ctx;
+            memset(&ctx, 0, sizeof(ctx));
+            ctx.ops = ops;
+            ctx.rounds = rounds;
+            ctx.gap_ticks = (uint64_t)(gaps_us[g] * 1e3 / bench_tsc_ns_per_tick);
+            ctx.lat = lat;
+
+            pthread_t ti, tr;
+            pthread_barrier_init(&ctx.barrier, NULL, 3);
+            pthread_create(&tr, NULL, responder, &ctx);
+            pthread_create(&ti, NULL, initiator, &ctx);
+            pthread_barrier_wait(&ctx.barrier);
+            double start = bench_now_ns();
+            pthread_join(ti, NULL);
+            pthread_join(tr, NULL);
+            double elapsed_ms = bench_elapsed_ms(start);
+            pthread_barrier_destroy(&ctx.barrier);
+
+            double pct[3];
+            bench_tick_quantiles(lat, rounds, (const double[]){ 0.50, 0.99, 1.0 }, 3, pct);
+            double p50 = pct[0], p99 = pct[1], max = pct[2];
+            double cpu_us = ctx.cpu_ms * 1e3 / rounds;
+            double cpu_pct = 100.0 * ctx.cpu_ms / elapsed_ms;
+            printf("%-11s %7d %7ld %10.0f %10.0f %10.0f %12.2f %8.1f\n", ops->name, gaps_us[g], rounds,
+                   p50, p99, max, cpu_us, cpu_pct);
+            fflush(stdout);
+            bench_report("wait", elapsed_ms, rounds, 0,
+                         "waiter=%s,gap_us=%d,latency_p50_ns=%.0f,latency_p99_ns=%.0f,"
+                         "latency_max_ns=%.0f,cpu_us_per_op=%.3f,cpu_pct=%.1f",
+                         ops->name, gaps_us[g], p50, p99, max, cpu_us, cpu_pct);
+        }
+    }
+    printf("\nLatency: initiator stamp -> responder running after its wait returns.\n"
+           "CPU: responder thread CPU time, per handoff and as a share of wall time.\n"
+           "spin_futex spins %d us before it parks.\n", WAITER_SPIN_US);
+    free(lat);
+    return 0;
+}
@@ -0,0 +1,174 @@
+#ifndef WAITERS_H
+#define WAITERS_H
+
+// Pluggable ways to wait for a 32-bit word to change, behind one table:
+//   spin        reload the word as fast as possible
+//   pause       reload with a pause (x86) / yield (arm64) hint in between
+//   backoff     exponentially growing runs of pause between reloads
+//   yield       sched_yield() between reloads
+//   spin_futex  spin for WAITER_SPIN_US, then sleep in FUTEX_WAIT
+//   umwait      UMONITOR the line, UMWAIT until it is written (WAITPKG)
+//   tpause      TPAUSE for a short TSC deadline between reloads (WAITPKG)
+// The waker calls ops->wake, which stores the new value and, for
+// spin_futex, issues FUTEX_WAKE only if a waiter has gone to sleep.
+//
+//   wait_word_t w = { 0 };
+//   waiter: ops->wait(&w, old);        returns once w.value != old
+//   waker:  ops->wake(&w, old + 1);
+//
+// spin_futex times its spin with the cycle counter, so call
+// bench_tick_calibrate() before any thread waits.
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <linux/futex.h>
+#include <sched.h>
+#include <stdint.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <immintrin.h>
+#include <x86intrin.h>
+#endif
+#include "../common/bench_stats.h"
+
+#define WAITER_LINE 64
+#define WAITER_SPIN_US 4            // spin_futex spin before parking, about one futex sleep + wake
+#define WAITER_BACKOFF_MAX 1024     // Pause instructions per backoff step, at most
+#define WAITER_TPAUSE_TICKS 1000    // TSC ticks per TPAUSE
+#define WAITER_UMWAIT_TICKS 100000  // TSC deadline per UMWAIT (the OS may cap it lower)
+
+typedef struct {
+    uint32_t value __attribute__((aligned(WAITER_LINE)));
+    uint32_t sleepers;          // spin_futex waiters inside FUTEX_WAIT
+} wait_word_t;
+
+static inline void waiter_cpu_relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ volatile("yield" ::: "memory");
+#else
+    __asm__ volatile("" ::: "memory");
+#endif
+}
+
+static inline uint32_t waiter_load(wait_word_t *w) {
+    return __atomic_load_n(&w->value, __ATOMIC_ACQUIRE);
+}
+
+static inline void waiter_store(wait_word_t *w, uint32_t v) {
+    __atomic_store_n(&w->value, v, __ATOMIC_RELEASE);
+}
+
+static inline int waiter_always(void) {
+    return 1;
+}
+
+static void spin_wait(wait_word_t *w, uint32_t old) {
+    while (waiter_load(w) == old) {
+    }
+}
+
+static void pause_wait(wait_word_t *w, uint32_t old) {
+    while (waiter_load(w) == old) waiter_cpu_relax();
+}
+
+static void backoff_wait(wait_word_t *w, uint32_t old) {
+    int backoff = 1;
+    while (waiter_load(w) == old) {
+        for (int i = 0; i < backoff; i++) waiter_cpu_relax();
+        if (backoff < WAITER_BACKOFF_MAX) backoff *= 2;
+    }
+}
+
+static void yield_wait(wait_word_t *w, uint32_t old) {
+    while (waiter_load(w) == old) sched_yield();
+}
+
+// ---- spin then futex ----
+// Waiter: announce itself in sleepers, then FUTEX_WAIT, which rechecks value
+// in the kernel. Waker: store value, then read sleepers; both sides use
+// seq_cst so one of them always sees the other and no wakeup is lost.
+
+static inline long waiter_futex(uint32_t *addr, int op, uint32_t val) {
+    return syscall(SYS_futex, addr, op, val, NULL, NULL, 0);
+}
+
+// The spin is bounded by time, not polls: one pause is ~10 cycles on older
+// Intel cores but ~140 on Skylake and later
+static void futex_wait_word(wait_word_t *w, uint32_t old) {
+    uint64_t deadline = bench_cycle_counter() + (uint64_t)(WAITER_SPIN_US * 1e3 / bench_tsc_ns_per_tick);
+    do {
+        if (waiter_load(w) != old) return;
+        waiter_cpu_relax();
+    } while (bench_cycle_counter() < deadline);
+    __atomic_fetch_add(&w->sleepers, 1, __ATOMIC_SEQ_CST);
+    while (__atomic_load_n(&w->value, __ATOMIC_SEQ_CST) == old) {
+        waiter_futex(&w->value, FUTEX_WAIT_PRIVATE, old);
+    }
+    __atomic_fetch_sub(&w->sleepers, 1, __ATOMIC_RELAXED);
+}
+
+static void futex_wake_word(wait_word_t *w, uint32_t v) {
+    __atomic_store_n(&w->value, v, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&w->sleepers, __ATOMIC_SEQ_CST)) {
+        waiter_futex(&w->value, FUTEX_WAKE_PRIVATE, 1);
+    }
+}
+
+// ---- WAITPKG (Tremont, Alder Lake, Sapphire Rapids and later) ----
+// UMWAIT/TPAUSE state 0 is the deeper C0.2; both return early on interrupts
+// and at the OS cap in IA32_UMWAIT_CONTROL, so they sit in a loop.
+
+#if defined(__x86_64__) || defined(__i386__)
+static inline int waitpkg_available(void) {
+    unsigned a, b, c, d;
+    return __get_cpuid_count(7, 0, &a, &b, &c, &d) && (c & (1u << 5));
+}
+
+__attribute__((target("waitpkg")))
+static void umwait_wait(wait_word_t *w, uint32_t old) {
+    while (waiter_load(w) == old) {
+        _umonitor(&w->value);
+        // Recheck after arming: a store before UMONITOR would not wake us
+        if (waiter_load(w) != old) break;
+        _umwait(0, __rdtsc() + WAITER_UMWAIT_TICKS);
+    }
+}
+
+__attribute__((target("waitpkg")))
+static void tpause_wait(wait_word_t *w, uint32_t old) {
+    while (waiter_load(w) == old) _tpause(0, __rdtsc() + WAITER_TPAUSE_TICKS);
+}
+#else
+static inline int waitpkg_available(void) {
+    return 0;
+}
+
+#define umwait_wait pause_wait
+#define tpause_wait pause_wait
+#endif
+
+typedef struct {
+    const char *name;
+    void (*wait)(wait_word_t *w, uint32_t old);
+    void (*wake)(wait_word_t *w, uint32_t v);
+    int (*available)(void);     // CPU support; unavailable kinds are skipped
+    int releases_cpu;           // Lets another thread run on this CPU while waiting
+} waiter_ops_t;
+
+static const waiter_ops_t waiter_kinds[] = {
+    { "spin",       spin_wait,       waiter_store,    waiter_always,     0 },
+    { "pause",      pause_wait,      waiter_store,    waiter_always,     0 },
+    { "backoff",    backoff_wait,    waiter_store,    waiter_always,     0 },
+    { "yield",      yield_wait,      waiter_store,    waiter_always,     1 },
+    { "spin_futex", futex_wait_word, futex_wake_word, waiter_always,     1 },
+    { "umwait",     umwait_wait,     waiter_store,    waitpkg_available, 0 },
+    { "tpause",     tpause_wait,     waiter_store,    waitpkg_available, 0 },
+};
+#define NUM_WAITER_KINDS (int)(sizeof(waiter_kinds) / sizeof(waiter_kinds[0]))
+
+#endif
@@ -0,0 +1,301 @@
+#include <errno.h>
+#include <linux/futex.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#include "bind_threads.h"
+#include "../common/bench_stats.h"
+
+#define DEFAULT_ROUNDS 10000        // Wakeups per (mechanism, placement) cell
+#define SLEEP_GAP_NS 20000          // Waker sleeps this long so the sleeper is really asleep
+#define HIST_BUCKETS 14             // < 0.5 us, doubling from there, last one >= 2 ms
+#define HIST_WIDTH 40
+
+// Wake-to-run latency: the sleeper announces each round and blocks in the
+// mechanism under test; the waker waits for the announcement, sleeps
+// SLEEP_GAP_NS so the sleeper has gone all the way into the kernel, stamps
+// the cycle counter and posts. The sleeper records now - stamp as soon as its
+// wait returns. Run for each mechanism at every placement bind_threads.h
+// can find: same CPU, SMT sibling, same L3 and cross socket.
+
+typedef struct {
+    // Per-mechanism state
+    uint32_t futex_word;
+    int efd;
+    int pipefd[2];
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    uint32_t cond_seq;
+    sem_t sem;
+    pthread_t sleeper;
+    uint32_t seen;              // Sleeper's last observed futex/condvar value
+
+    uint64_t stamp __attribute__((aligned(64)));
+    uint32_t ready __attribute__((aligned(64)));  // Rounds the sleeper is about to wait for
+} wake_chan_t;
+
+static long sys_futex(uint32_t *addr, int op, uint32_t val) {
+    return syscall(SYS_futex, addr, op, val, NULL, NULL, 0);
+}
+
+static void futex_wait(wake_chan_t *c) {
+    while (__atomic_load_n(&c->futex_word, __ATOMIC_ACQUIRE) == c->seen) {
+        sys_futex(&c->futex_word, FUTEX_WAIT_PRIVATE, c->seen);
+    }
+    c->seen = __atomic_load_n(&c->futex_word, __ATOMIC_ACQUIRE);
+}
+
+static void futex_post(wake_chan_t *c) {
+    __atomic_fetch_add(&c->futex_word, 1, __ATOMIC_RELEASE);
+    sys_futex(&c->futex_word, FUTEX_WAKE_PRIVATE, 1);
+}
+
+static void eventfd_wait(wake_chan_t *c) {
+    uint64_t v;
+    while (read(c->efd, &v, sizeof(v)) != sizeof(v) && errno == EINTR) {
+    }
+}
+
+static void eventfd_post(wake_chan_t *c) {
+    uint64_t v = 1;
+    if (write(c->efd, &v, sizeof(v)) != sizeof(v)) perror("eventfd write");
+}
+
+static void pipe_wait(wake_chan_t *c) {
+    char b;
+    while (read(c->pipefd[0], &b, 1) != 1 && errno == EINTR) {
+    }
+}
+
+static void pipe_post(wake_chan_t *c) {
+    if (write(c->pipefd[1], "x", 1) != 1) perror("pipe write");
+}
+
+static void condvar_wait(wake_chan_t *c) {
+    pthread_mutex_lock(&c->lock);
+    while (c->cond_seq == c->seen) pthread_cond_wait(&c->cond, &c->lock);
+    c->seen = c->cond_seq;
+    pthread_mutex_unlock(&c->lock);
+}
+
+static void condvar_post(wake_chan_t *c) {
+    pthread_mutex_lock(&c->lock);
+    c->cond_seq++;
+    pthread_cond_signal(&c->cond);
+    pthread_mutex_unlock(&c->lock);
+}
+
+static void sem_wait_chan(wake_chan_t *c) {
+    while (sem_wait(&c->sem) != 0 && errno == EINTR) {
+    }
+}
+
+static void sem_post_chan(wake_chan_t *c) {
+    sem_post(&c->sem);
+}
+
+// SIGUSR1 is blocked in every thread, so it is only ever taken by sigwaitinfo
+static void signal_wait(wake_chan_t *c) {
+    sigset_t set;
+    (void)c;
+    sigemptyset(&set);
+    sigaddset(&set, SIGUSR1);
+    while (sigwaitinfo(&set, NULL) < 0 && errno == EINTR) {
+    }
+}
+
+static void signal_post(wake_chan_t *c) {
+    pthread_kill(c->sleeper, SIGUSR1);
+}
+
+typedef struct {
+    const char *name;
+    void (*wait)(wake_chan_t *c);
+    void (*post)(wake_chan_t *c);
+} wake_ops_t;
+
+static const wake_ops_t wake_kinds[] = {
+    { "futex",     futex_wait,    futex_post },
+    { "eventfd",   eventfd_wait,  eventfd_post },
+    { "pipe",      pipe_wait,     pipe_post },
+    { "condvar",   condvar_wait,  condvar_post },
+    { "semaphore", sem_wait_chan, sem_post_chan },
+    { "signal",    signal_wait,   signal_post },
+};
+#define NUM_WAKE_KINDS (int)(sizeof(wake_kinds) / sizeof(wake_kinds[0]))
+
+static const topo_relation_t placements[] = {
+    TOPO_SAME_CPU, TOPO_SMT_SIBLING, TOPO_SAME_L3, TOPO_CROSS_PACKAGE,
+};
+#define NUM_PLACEMENTS (int)(sizeof(placements) / sizeof(placements[0]))
+
+static int chan_init(wake_chan_t *c) {
+    memset(c, 0, sizeof(*c));
+    c->efd = eventfd(0, EFD_CLOEXEC);
+    if (c->efd < 0 || pipe(c->pipefd) != 0) return -1;
+    if (pthread_mutex_init(&c->lock, NULL) != 0 || pthread_cond_init(&c->cond, NULL) != 0) return -1;
+    return sem_init(&c->sem, 0, 0);
+}
+
+static void chan_destroy(wake_chan_t *c) {
+    close(c->efd);
+    close(c->pipefd[0]);
+    close(c->pipefd[1]);
+    pthread_mutex_destroy(&c->lock);
+    pthread_cond_destroy(&c->cond);
+    sem_destroy(&c->sem);
+}
+
+typedef struct {
+    const wake_ops_t *ops;
+    wake_chan_t chan;
+    int waker_cpu, sleeper_cpu;
+    long rounds;
+    uint32_t *lat;              // Wake-to-run latency per round, cycle-counter ticks
+    pthread_barrier_t barrier;
+} wake_ctx_t;
+
+static void *waker_thread(void *arg) {
+    wake_ctx_t *w = (wake_ctx_t *)arg;
+    struct timespec gap = { 0, SLEEP_GAP_NS };
+    bind_thread_to_core(w->waker_cpu);
+    prctl(PR_SET_TIMERSLACK, 1UL);
+    pthread_barrier_wait(&w->barrier);
+    for (uint32_t r = 0; r < w->rounds; r++) {
+        // Yield rather than spin so a sleeper on this same CPU can get there
+        while (__atomic_load_n(&w->chan.ready, __ATOMIC_ACQUIRE) <= r) sched_yield();
+        nanosleep(&gap, NULL);
+        __atomic_store_n(&w->chan.stamp, bench_cycle_counter(), __ATOMIC_RELAXED);
+        w->ops->post(&w->chan);
+    }
+    return NULL;
+}
+
+static void *sleeper_thread(void *arg) {
+    wake_ctx_t *w = (wake_ctx_t *)arg;
+    bind_thread_to_core(w->sleeper_cpu);
+    pthread_barrier_wait(&w->barrier);
+    for (uint32_t r = 0; r < w->rounds; r++) {
+        __atomic_store_n(&w->chan.ready, r + 1, __ATOMIC_RELEASE);
+        w->ops->wait(&w->chan);
+        uint64_t dt = bench_cycle_counter() - __atomic_load_n(&w->chan.stamp, __ATOMIC_RELAXED);
+        w->lat[r] = dt > UINT32_MAX ? UINT32_MAX : (uint32_t)dt;
+    }
+    return NULL;
+}
+
+// Bucket 0: < 0.5 us; bucket b: [2^(b-2), 2^(b-1)) us; the last one is open
+static int hist_bucket(double ns) {
+    int b = 0;
+    for (double edge = 500; ns >= edge && b < HIST_BUCKETS - 1; edge *= 2) b++;
+    return b;
+}
+
+static void print_histogram(const uint32_t *sorted, long n) {
+    long count[HIST_BUCKETS] = { 0 }, peak = 0;
+    for (long i = 0; i < n; i++) count[hist_bucket(sorted[i] * bench_tsc_ns_per_tick)]++;
+    for (int b = 0; b < HIST_BUCKETS; b++) {
+        if (count[b] > peak) peak = count[b];
+    }
+    int first = 0, last = HIST_BUCKETS - 1;
+    while (first < last && count[first] == 0) first++;
+    while (last > first && count[last] == 0) last--;
+    for (int b = first; b <= last; b++) {
+        double lo = b ? 250.0 * (1 << b) : 0, hi = 250.0 * (1 << (b + 1));
+        char range[32];
+        if (b == HIST_BUCKETS - 1) snprintf(range, sizeof(range), ">= %.0f us", lo / 1e3);
+        else snprintf(range, sizeof(range), "%.1f - %.1f us", lo / 1e3, hi / 1e3);
+        int bar = peak ? (int)((double)count[b] * HIST_WIDTH / peak + 0.5) : 0;
+        printf("    %18s %7ld %6.2f%% |", range, count[b], 100.0 * count[b] / n);
+        for (int i = 0; i < bar; i++) putchar('#');
+        putchar('\n');
+    }
+}
+
+int main(int argc, char *argv[]) {
+    argc = bench_init(argc, argv, "wakeup_bench");
+    argc = bench_stats_init(argc, argv);
+    argc = topo_init_args(argc, argv);
+    long rounds = argc >= 2 ? atol(argv[1]) : DEFAULT_ROUNDS;
+    if (rounds < 1) {
+        printf("Usage: %s [rounds] [--format text|json|csv]\n", argv[0]);
+        return 1;
+    }
+    bench_tick_calibrate();
+
+    // Block SIGUSR1 before any thread exists so every thread inherits it
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGUSR1);
+    pthread_sigmask(SIG_BLOCK, &set, NULL);
+
+    const topo_t *topo = topo_get();
+    printf("=== Cross-Thread Wakeup Latency ===\n");
+    topo_print(topo);
+    printf("%ld wakeups per cell, waker sleeps %d us before each post\n\n", rounds, SLEEP_GAP_NS / 1000);
+
+    uint32_t *lat = malloc(rounds * sizeof(uint32_t));
+    static wake_ctx_t ctx;
+    if (!lat) {
+        perror("malloc");
+        return 1;
+    }
+    for (int p = 0; p < NUM_PLACEMENTS; p++) {
+        int a, b;
+        if (topo_find_pair(topo, placements[p], &a, &b) != 0) {
+            printf("📍 %s: no such CPU pair on this machine, skipped\n\n", topo_relation_names[placements[p]]);
+            continue;
+        }
+        printf("📍 %s: waker on CPU %d, sleeper on CPU %d\n", topo_relation_names[placements[p]], a, b);
+        printf("  %-10s %9s %9s %9s %9s %10s\n", "Mechanism", "p50 ns", "p90 ns", "p99 ns", "p99.9 ns",
+               "max ns");
+        for (int k = 0; k < NUM_WAKE_KINDS; k++) {
+            const wake_ops_t *ops = &wake_kinds[k];
+            ctx.ops = ops;
+            ctx.waker_cpu = a;
+            ctx.sleeper_cpu = b;
+            ctx.rounds = rounds;
+            ctx.lat = lat;
+            if (chan_init(&ctx.chan) != 0) {
+                perror("chan_init");
+                return 1;
+            }
+
+            pthread_t tw, ts;
+            pthread_barrier_init(&ctx.barrier, NULL, 3);
+            pthread_create(&ts, NULL, sleeper_thread, &ctx);
+            ctx.chan.sleeper = ts;
+            pthread_create(&tw, NULL, waker_thread, &ctx);
+            pthread_barrier_wait(&ctx.barrier);
+            double start = bench_now_ns();
+            pthread_join(tw, NULL);
+            pthread_join(ts, NULL);
+            double elapsed_ms = bench_elapsed_ms(start);
+            pthread_barrier_destroy(&ctx.barrier);
+            chan_destroy(&ctx.chan);
+
+            double pct[5];
+            bench_tick_quantiles(lat, rounds, (const double[]){ 0.50, 0.90, 0.99, 0.999, 1.0 }, 5, pct);
+            double p50 = pct[0], p90 = pct[1], p99 = pct[2], p999 = pct[3], max = pct[4];
+            printf("  %-10s %9.0f %9.0f %9.0f %9.0f %10.0f\n", ops->name, p50, p90, p99, p999, max);
+            print_histogram(lat, rounds);
+            fflush(stdout);
+            bench_report("wakeup", elapsed_ms, rounds, 0,
+                         "mechanism=%s,placement=%s,waker_cpu=%d,sleeper_cpu=%d,p50_ns=%.0f,p90_ns=%.0f,"
+                         "p99_ns=%.0f,p999_ns=%.0f,max_ns=%.0f", ops->name,
+                         topo_relation_names[placements[p]], a, b, p50, p90, p99, p999, max);
+        }
+        printf("\n");
+    }
+    printf("Latency: waker's stamp just before posting -> sleeper running after its wait returns.\n");
+    free(lat);
+    return 0;
+}
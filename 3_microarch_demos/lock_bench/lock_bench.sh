@@ -0,0 +1,14 @@
+#!/bin/bash
+set -e
+
+gcc -O2 -pthread lock_shootout.c -o lock_shootout -lm
+
+# Short critical section: lock handoff cost dominates
+./lock_shootout $(nproc) 1 100 200
+
+# Longer critical section with little think time: queueing and fairness dominate
+./lock_shootout $(nproc) 16 10 200
+
+# Machine-readable rows for plotting
+./lock_shootout $(nproc) 2 100 200 --format json > lock_shootout.jsonl
+echo "INFO: lock rows written to lock_shootout.jsonl"
@@ -0,0 +1,183 @@
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../false_sharing_perf_demo/bind_threads.h"
+#include "../common/bench_stats.h"
+#include "locks.h"
+
+#define MAX_THREADS 256
+#define DEFAULT_CS_LINES 2          // Shared cache lines written inside the lock
+#define DEFAULT_THINK 100           // Local work iterations between acquisitions
+#define DEFAULT_DURATION_MS 200     // Per (lock, threads) cell
+#define CS_MAX_LINES 64
+
+// Each thread loops: time lock acquisition, write cs_lines shared lines plus
+// a shared op counter inside the lock, release, then do think iterations of
+// private work. Runs for a fixed duration; the shared counter must equal the
+// sum of per-thread counts or mutual exclusion was broken.
+
+typedef struct {
+    long v;
+    char pad[LOCK_LINE - sizeof(long)];
+} line_t;
+
+static bench_lock_t lock;
+static line_t cs_data[CS_MAX_LINES] __attribute__((aligned(LOCK_LINE)));
+static line_t cs_ops __attribute__((aligned(LOCK_LINE)));
+static int stop_flag __attribute__((aligned(LOCK_LINE)));
+static int cs_lines = DEFAULT_CS_LINES;
+static int think_iters = DEFAULT_THINK;
+
+typedef struct {
+    int core;
+    const lock_ops_t *ops;
+    pthread_barrier_t *barrier;
+    long count;
+    uint32_t *lat;              // Acquire latency ring, in cycle-counter ticks
+    bench_span_t span;
+} __attribute__((aligned(LOCK_LINE))) lock_worker_t;
+
+static void *lock_worker(void *arg) {
+    lock_worker_t *w = (lock_worker_t *)arg;
+    lock_thread_t self;
+    bind_thread_to_core(w->core);
+    if (lock_thread_init(&self) != 0) {
+        perror("lock_thread_init");
+        exit(1);
+    }
+
+    volatile long local = 0;
+    long count = 0;
+    pthread_barrier_wait(w->barrier);
+    bench_span_begin(&w->span);
+    while (!__atomic_load_n(&stop_flag, __ATOMIC_RELAXED)) {
+        uint64_t t0 = bench_cycle_counter();
+        w->ops->acquire(&lock, &self);
+        uint64_t t1 = bench_cycle_counter();
+        for (int i = 0; i < cs_lines; i++) cs_data[i].v++;
+        cs_ops.v++;
+        w->ops->release(&lock, &self);
+
+        bench_lat_record(w->lat, count, t1 - t0);
+        count++;
+        for (int i = 0; i < think_iters; i++) local++;
+    }
+    bench_span_end(&w->span);
+    w->count = count;
+    lock_thread_destroy(&self);
+    return NULL;
+}
+
+typedef struct {
+    double elapsed_ms;
+    long total;                 // Acquisitions by all threads
+    double mops;
+    double jain;                // Jain's fairness index over per-thread counts
+    long min_count, max_count;
+    double p50_ns, p99_ns, p999_ns, max_ns;
+    int ok;
+} cell_t;
+
+static cell_t run_cell(const lock_ops_t *ops, int nthreads, int duration_ms) {
+    pthread_t tids[MAX_THREADS];
+    static lock_worker_t workers[MAX_THREADS];
+    static uint32_t lat[MAX_THREADS * BENCH_LAT_SAMPLES];
+    pthread_barrier_t barrier;
+    cell_t c = { 0 };
+
+    if (bench_lock_init(&lock) != 0) {
+        perror("bench_lock_init");
+        exit(1);
+    }
+    memset(cs_data, 0, sizeof(cs_data));
+    cs_ops.v = 0;
+    stop_flag = 0;
+    pthread_barrier_init(&barrier, NULL, nthreads + 1);
+    for (int t = 0; t < nthreads; t++) {
+        workers[t] = (lock_worker_t){ .core = topo_cpu_for_thread(t), .ops = ops, .barrier = &barrier,
+                                      .lat = lat + (size_t)t * BENCH_LAT_SAMPLES };
+        pthread_create(&tids[t], NULL, lock_worker, &workers[t]);
+    }
+
+    pthread_barrier_wait(&barrier);
+    struct timespec ts = { duration_ms / 1000, (duration_ms % 1000) * 1000000L };
+    nanosleep(&ts, NULL);
+    __atomic_store_n(&stop_flag, 1, __ATOMIC_RELAXED);
+    for (int t = 0; t < nthreads; t++) pthread_join(tids[t], NULL);
+    double elapsed_ms = bench_span_ms(&workers[0].span, nthreads, sizeof(workers[0]));
+    pthread_barrier_destroy(&barrier);
+    bench_lock_destroy(&lock);
+
+    long total = 0, nlat = 0;
+    double sum = 0, sum_sq = 0;
+    c.min_count = workers[0].count;
+    for (int t = 0; t < nthreads; t++) {
+        long n = workers[t].count;
+        total += n;
+        sum += n;
+        sum_sq += (double)n * n;
+        if (n < c.min_count) c.min_count = n;
+        if (n > c.max_count) c.max_count = n;
+        nlat = bench_lat_append(lat, nlat, workers[t].lat, n);
+    }
+    c.ok = cs_ops.v == total;
+    c.elapsed_ms = elapsed_ms;
+    c.total = total;
+    c.mops = total / (elapsed_ms * 1e3);
+    c.jain = sum_sq > 0 ? sum * sum / (nthreads * sum_sq) : 0;
+
+    double pct[4];
+    bench_tick_quantiles(lat, nlat, (const double[]){ 0.50, 0.99, 0.999, 1.0 }, 4, pct);
+    c.p50_ns = pct[0], c.p99_ns = pct[1], c.p999_ns = pct[2], c.max_ns = pct[3];
+    return c;
+}
+
+int main(int argc, char *argv[]) {
+    argc = bench_init(argc, argv, "lock_shootout");
+    argc = bench_stats_init(argc, argv);
+    argc = topo_init_args(argc, argv);
+    int max_threads = argc >= 2 ? atoi(argv[1]) : topo_get()->ncpus;
+    cs_lines = argc >= 3 ? atoi(argv[2]) : DEFAULT_CS_LINES;
+    think_iters = argc >= 4 ? atoi(argv[3]) : DEFAULT_THINK;
+    int duration_ms = argc >= 5 ? atoi(argv[4]) : DEFAULT_DURATION_MS;
+    if (max_threads < 1 || max_threads > MAX_THREADS || cs_lines < 0 || cs_lines > CS_MAX_LINES ||
+        think_iters < 0 || duration_ms < 1) {
+        printf("Usage: %s [max_threads<=%d] [cs_lines<=%d] [think_iters] [duration_ms]\n"
+               "        [--format text|json|csv] [--placement linear|cores|pack|spread]\n", argv[0], MAX_THREADS, CS_MAX_LINES);
+        return 1;
+    }
+    bench_tick_calibrate();
+
+    printf("=== Lock Shootout ===\n");
+    printf("Critical section: %d shared lines, think: %d iterations, %d ms per cell\n",
+           cs_lines, think_iters, duration_ms);
+    topo_print(topo_get());
+    printf("\n");
+    printf("%-14s %7s %10s %7s %19s %10s %10s %10s %12s\n", "Lock", "Threads", "Mops/s",
+           "Jain", "min/max ops", "p50 ns", "p99 ns", "p99.9 ns", "max ns");
+
+    for (int k = 0; k < NUM_LOCK_KINDS; k++) {
+        const lock_ops_t *ops = &lock_kinds[k];
+        // 1, 2, 4, ... and finally max_threads itself
+        for (int n = 1;; n *= 2) {
+            if (n > max_threads) n = max_threads;
+            cell_t c = run_cell(ops, n, duration_ms);
+            printf("%-14s %7d %10.2f %7.3f %9ld/%-9ld %10.0f %10.0f %10.0f %12.0f%s\n", ops->name, n,
+                   c.mops, c.jain, c.min_count, c.max_count, c.p50_ns, c.p99_ns, c.p999_ns,
+                   c.max_ns, c.ok ? "" : "  MUTUAL EXCLUSION BROKEN");
+            bench_report("lock", c.elapsed_ms, c.total, 0,
+                         "lock=%s,threads=%d,cs_lines=%d,think=%d,jain=%.4f,min_ops=%ld,max_ops=%ld,"
+                         "acquire_p50_ns=%.0f,acquire_p99_ns=%.0f,acquire_p999_ns=%.0f",
+                         ops->name, n, cs_lines, think_iters, c.jain, c.min_count, c.max_count,
+                         c.p50_ns, c.p99_ns, c.p999_ns);
+            if (n == max_threads) break;
+        }
+    }
+    printf("\nJain = (sum ops)^2 / (threads * sum ops^2): 1.0 is perfectly fair.\n"
+           "Acquire latency: time from calling acquire to holding the lock, last %d per thread.\n",
+           BENCH_LAT_SAMPLES);
+    return 0;
+}
@@ -0,0 +1,243 @@
+#ifndef LOCKS_H
+#define LOCKS_H
+
+// Lock implementations for the shootout, behind one acquire/release table.
+// Queue locks (MCS, CLH) need per-thread state, so every call gets the
+// caller's lock_thread_t; the other locks ignore it.
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <linux/futex.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#define LOCK_LINE 64
+#define LOCK_BACKOFF_MIN 4
+#define LOCK_BACKOFF_MAX 1024
+
+static inline void lock_cpu_relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ volatile("yield" ::: "memory");
+#else
+    __asm__ volatile("" ::: "memory");
+#endif
+}
+
+typedef struct mcs_node {
+    struct mcs_node *next;
+    int locked;
+} __attribute__((aligned(LOCK_LINE))) mcs_node_t;
+
+typedef struct {
+    int locked;
+} __attribute__((aligned(LOCK_LINE))) clh_node_t;
+
+typedef struct {
+    mcs_node_t mcs;
+    clh_node_t *clh_node;       // Node this thread enqueues next
+    clh_node_t *clh_pred;       // Predecessor's node, recycled on release
+} lock_thread_t;
+
+// Every lock kind gets its own line(s) so only the one under test is hot
+typedef struct {
+    int tas __attribute__((aligned(LOCK_LINE)));
+    struct {
+        unsigned next;
+        unsigned owner;
+    } ticket __attribute__((aligned(LOCK_LINE)));
+    mcs_node_t *mcs_tail __attribute__((aligned(LOCK_LINE)));
+    clh_node_t *clh_tail __attribute__((aligned(LOCK_LINE)));
+    int futex __attribute__((aligned(LOCK_LINE)));      // 0 free, 1 locked, 2 locked + waiters
+    pthread_mutex_t mutex __attribute__((aligned(LOCK_LINE)));
+    pthread_spinlock_t spin __attribute__((aligned(LOCK_LINE)));
+} bench_lock_t;
+
+// ---- Test-and-set: every waiter hammers the line with atomic exchanges ----
+
+static inline void tas_acquire(bench_lock_t *l, lock_thread_t *t) {
+    (void)t;
+    while (__atomic_exchange_n(&l->tas, 1, __ATOMIC_ACQUIRE)) lock_cpu_relax();
+}
+
+static inline void tas_release(bench_lock_t *l, lock_thread_t *t) {
+    (void)t;
+    __atomic_store_n(&l->tas, 0, __ATOMIC_RELEASE);
+}
+
+// ---- Test-and-test-and-set with exponential backoff: spin on a shared
+// (read-only) copy, and back off after a lost exchange ----
+
+static inline void ttas_acquire(bench_lock_t *l, lock_thread_t *t) {
+    (void)t;
+    unsigned backoff = LOCK_BACKOFF_MIN;
+    for (;;) {
+        while (__atomic_load_n(&l->tas, __ATOMIC_RELAXED)) lock_cpu_relax();
+        if (!__atomic_exchange_n(&l->tas, 1, __ATOMIC_ACQUIRE)) return;
+        for (unsigned i = 0; i < backoff; i++) lock_cpu_relax();
+        if (backoff < LOCK_BACKOFF_MAX) backoff *= 2;
+    }
+}
+
+// ---- Ticket: FIFO, but all waiters still spin on the owner field ----
+
+static inline void ticket_acquire(bench_lock_t *l, lock_thread_t *t) {
+    (void)t;
+    unsigned me = __atomic_fetch_add(&l->ticket.next, 1, __ATOMIC_RELAXED);
+    while (__atomic_load_n(&l->ticket.owner, __ATOMIC_ACQUIRE) != me) lock_cpu_relax();
+}
+
+static inline void ticket_release(bench_lock_t *l, lock_thread_t *t) {
+    (void)t;
+    __atomic_store_n(&l->ticket.owner, l->ticket.owner + 1, __ATOMIC_RELEASE);
+}
+
+// ---- MCS: FIFO queue, each waiter spins on its own node ----
+
+static inline void mcs_acquire(bench_lock_t *l, lock_thread_t *t) {
+    mcs_node_t *me = &t->mcs;
+    me->next = NULL;
+    me->locked = 1;
+    mcs_node_t *pred = __atomic_exchange_n(&l->mcs_tail, me, __ATOMIC_ACQ_REL);
+    if (!pred) return;
+    __atomic_store_n(&pred->next, me, __ATOMIC_RELEASE);
+    while (__atomic_load_n(&me->locked, __ATOMIC_ACQUIRE)) lock_cpu_relax();
+}
+
+static inline void mcs_release(bench_lock_t *l, lock_thread_t *t) {
+    mcs_node_t *me = &t->mcs;
+    mcs_node_t *next = __atomic_load_n(&me->next, __ATOMIC_ACQUIRE);
+    if (!next) {
+        mcs_node_t *expected = me;
+        if (__atomic_compare_exchange_n(&l->mcs_tail, &expected, NULL, 0,
+                                        __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+            return;
+        }
+        // A successor swapped the tail but has not linked itself yet
+        while (!(next = __atomic_load_n(&me->next, __ATOMIC_ACQUIRE))) lock_cpu_relax();
+    }
+    __atomic_store_n(&next->locked, 0, __ATOMIC_RELEASE);
+}
+
+// ---- CLH: FIFO queue, each waiter spins on its predecessor's node ----
+
+static inline void clh_acquire(bench_lock_t *l, lock_thread_t *t) {
+    clh_node_t *me = t->clh_node;
+    me->locked = 1;
+    clh_node_t *pred = __atomic_exchange_n(&l->clh_tail, me, __ATOMIC_ACQ_REL);
+    while (__atomic_load_n(&pred->locked, __ATOMIC_ACQUIRE)) lock_cpu_relax();
+    t->clh_pred = pred;
+}
+
+static inline void clh_release(bench_lock_t *l, lock_thread_t *t) {
+    (void)l;
+    clh_node_t *me = t->clh_node;
+    __atomic_store_n(&me->locked, 0, __ATOMIC_RELEASE);
+    t->clh_node = t->clh_pred;  // Our node now belongs to the successor
+}
+
+// ---- Raw futex: Drepper's three-state mutex ("Futexes Are Tricky") ----
+
+static inline long lock_futex(int *addr, int op, int val) {
+    return syscall(SYS_futex, addr, op, val, NULL, NULL, 0);
+}
+
+static inline void futex_acquire(bench_lock_t *l, lock_thread_t *t) {
+    (void)t;
+    int c = 0;
+    if (__atomic_compare_exchange_n(&l->futex, &c, 1, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) return;
+    if (c != 2) c = __atomic_exchange_n(&l->futex, 2, __ATOMIC_ACQUIRE);
+    while (c != 0) {
+        lock_futex(&l->futex, FUTEX_WAIT_PRIVATE, 2);
+        c = __atomic_exchange_n(&l->futex, 2, __ATOMIC_ACQUIRE);
+    }
+}
+
+static inline void futex_release(bench_lock_t *l, lock_thread_t *t) {
+    (void)t;
+    if (__atomic_exchange_n(&l->futex, 0, __ATOMIC_RELEASE) == 2) {
+        lock_futex(&l->futex, FUTEX_WAKE_PRIVATE, 1);
+    }
+}
+
+// ---- pthread ----
+
+static inline void mutex_acquire(bench_lock_t *l, lock_thread_t *t) {
+    (void)t;
+    pthread_mutex_lock(&l->mutex);
+}
+
+static inline void mutex_release(bench_lock_t *l, lock_thread_t *t) {
+    (void)t;
+    pthread_mutex_unlock(&l->mutex);
+}
+
+static inline void spin_acquire(bench_lock_t *l, lock_thread_t *t) {
+    (void)t;
+    pthread_spin_lock(&l->spin);
+}
+
+static inline void spin_release(bench_lock_t *l, lock_thread_t *t) {
+    (void)t;
+    pthread_spin_unlock(&l->spin);
+}
+
+typedef struct {
+    const char *name;
+    void (*acquire)(bench_lock_t *l, lock_thread_t *t);
+    void (*release)(bench_lock_t *l, lock_thread_t *t);
+} lock_ops_t;
+
+static const lock_ops_t lock_kinds[] = {
+    { "tas",           tas_acquire,    tas_release },
+    { "ttas_backoff",  ttas_acquire,   tas_release },
+    { "ticket",        ticket_acquire, ticket_release },
+    { "mcs",           mcs_acquire,    mcs_release },
+    { "clh",           clh_acquire,    clh_release },
+    { "futex",         futex_acquire,  futex_release },
+    { "pthread_mutex", mutex_acquire,  mutex_release },
+    { "pthread_spin",  spin_acquire,   spin_release },
+};
+#define NUM_LOCK_KINDS (int)(sizeof(lock_kinds) / sizeof(lock_kinds[0]))
+
+// CLH nodes circulate between threads: each thread brings one heap node and
+// leaves with whichever it holds last, and the lock owns the node at the tail
+// (initially a released dummy). So n threads always share n + 1 nodes.
+
+static inline int bench_lock_init(bench_lock_t *l) {
+    l->tas = 0;
+    l->ticket.next = l->ticket.owner = 0;
+    l->mcs_tail = NULL;
+    l->clh_tail = aligned_alloc(LOCK_LINE, sizeof(clh_node_t));
+    if (!l->clh_tail) return -1;
+    l->clh_tail->locked = 0;
+    l->futex = 0;
+    if (pthread_mutex_init(&l->mutex, NULL) != 0) return -1;
+    return pthread_spin_init(&l->spin, PTHREAD_PROCESS_PRIVATE) == 0 ? 0 : -1;
+}
+
+static inline void bench_lock_destroy(bench_lock_t *l) {
+    free(l->clh_tail);
+    pthread_mutex_destroy(&l->mutex);
+    pthread_spin_destroy(&l->spin);
+}
+
+static inline int lock_thread_init(lock_thread_t *t) {
+    t->mcs.next = NULL;
+    t->mcs.locked = 0;
+    t->clh_node = aligned_alloc(LOCK_LINE, sizeof(clh_node_t));
+    t->clh_pred = NULL;
+    return t->clh_node ? 0 : -1;
+}
+
+static inline void lock_thread_destroy(lock_thread_t *t) {
+    free(t->clh_node);
+    t->clh_node = NULL;
+}
+
+#endif